@@ -0,0 +1,151 @@
+/* File:     bloom.c
+ *
+ * Purpose:  Implement a counting Bloom filter of ints that can be
+ *           shared by threads.  It can tell that a key is definitely
+ *           not in a set much faster than searching the set.
+ *
+ * Bloom_init:     allocate an empty filter sized for about expected_keys
+ *                 keys
+ * Bloom_add:      add a key
+ * Bloom_remove:   remove a key that was added
+ * Bloom_maybe:    return 0 if key is definitely not in the filter, and
+ *                 1 if it may be
+ * Bloom_destroy:  free the filter
+ *
+ * Notes:
+ * 1.  The filter is an array of 8-bit counters.  A key is hashed to
+ *     HASHES counters, and Bloom_add increments them, Bloom_remove
+ *     decrements them, and Bloom_maybe checks that none of them is 0.
+ * 2.  There are BITS_PER_KEY*expected_keys counters, rounded up to a
+ *     power of 2.  With 10 counters per key and 7 hashes, about 1% of
+ *     the keys that aren't in the filter get "maybe".
+ * 3.  The counters are updated with atomic operations, so threads can
+ *     add and remove keys at the same time without a lock.
+ * 4.  A counter that reaches COUNT_MAX sticks there:  it's never
+ *     decremented, since it may be counting more keys than it can
+ *     record.  So a key that's in the filter is never reported as
+ *     definitely missing.
+ * 5.  The counters for a key are found by double hashing:  the i-th
+ *     is (h1 + i*h2) mod the number of counters.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "bloom.h"
+
+#define BITS_PER_KEY 10
+#define HASHES 7
+#define COUNT_MAX 255
+
+struct bloom_s {
+   unsigned char* counts;
+   unsigned long  mask;       /* Number of counters - 1 */
+};
+
+static void Hash(int key, unsigned long* h1_p, unsigned long* h2_p);
+
+/*-----------------------------------------------------------------*/
+/* Function:   Bloom_init
+ * Purpose:    Allocate an empty filter
+ * In arg:     expected_keys, the number of keys that are expected to
+ *             be in the filter at one time
+ * Return val: Pointer to the filter
+ */
+struct bloom_s* Bloom_init(int expected_keys) {
+   struct bloom_s* bloom_p = malloc(sizeof(struct bloom_s));
+   unsigned long size = 64;
+
+   if (expected_keys < 1) expected_keys = 1;
+   while (size < (unsigned long) BITS_PER_KEY*expected_keys)
+      size *= 2;
+   bloom_p->mask = size - 1;
+   bloom_p->counts = calloc(size, sizeof(unsigned char));
+   if (bloom_p->counts == NULL) {
+      fprintf(stderr, "Bloom_init:  can't allocate %lu counters\n", size);
+      exit(-1);
+   }
+   return bloom_p;
+}  /* Bloom_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Bloom_add
+ * Purpose:    Increment the counters for key, unless they're stuck
+ */
+void Bloom_add(struct bloom_s* bloom_p, int key) {
+   unsigned long h1, h2;
+   unsigned char* count_p;
+   unsigned char old;
+   int i;
+
+   Hash(key, &h1, &h2);
+   for (i = 0; i < HASHES; i++) {
+      count_p = &bloom_p->counts[(h1 + i*h2) & bloom_p->mask];
+      old = __atomic_load_n(count_p, __ATOMIC_RELAXED);
+      while (old != COUNT_MAX &&
+            !__atomic_compare_exchange_n(count_p, &old, old + 1, 0,
+               __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+         ;
+   }
+}  /* Bloom_add */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Bloom_remove
+ * Purpose:    Decrement the counters for key, unless they're stuck
+ */
+void Bloom_remove(struct bloom_s* bloom_p, int key) {
+   unsigned long h1, h2;
+   unsigned char* count_p;
+   unsigned char old;
+   int i;
+
+   Hash(key, &h1, &h2);
+   for (i = 0; i < HASHES; i++) {
+      count_p = &bloom_p->counts[(h1 + i*h2) & bloom_p->mask];
+      old = __atomic_load_n(count_p, __ATOMIC_RELAXED);
+      while (old != COUNT_MAX && old != 0 &&
+            !__atomic_compare_exchange_n(count_p, &old, old - 1, 0,
+               __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+         ;
+   }
+}  /* Bloom_remove */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Bloom_maybe
+ * Purpose:    Check whether key may be in the filter
+ * Return val: 0 if key is definitely not in the filter, 1 otherwise
+ */
+int Bloom_maybe(struct bloom_s* bloom_p, int key) {
+   unsigned long h1, h2;
+   int i;
+
+   Hash(key, &h1, &h2);
+   for (i = 0; i < HASHES; i++)
+      if (__atomic_load_n(&bloom_p->counts[(h1 + i*h2) & bloom_p->mask],
+               __ATOMIC_RELAXED) == 0)
+         return 0;
+   return 1;
+}  /* Bloom_maybe */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Bloom_destroy
+ * Purpose:    Free the storage used by the filter
+ */
+void Bloom_destroy(struct bloom_s* bloom_p) {
+   free(bloom_p->counts);
+   free(bloom_p);
+}  /* Bloom_destroy */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Hash
+ * Purpose:    Compute the two hash values used to find the counters
+ *             for key.  h2 is odd, so the counters are distinct.
+ * Note:       This is the finalizer from the splitmix64 generator
+ */
+static void Hash(int key, unsigned long* h1_p, unsigned long* h2_p) {
+   unsigned long long z = (unsigned) key + 0x9e3779b97f4a7c15ULL;
+
+   z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+   z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+   z = z ^ (z >> 31);
+   *h1_p = z;
+   *h2_p = (z >> 32) | 1;
+}  /* Hash */
@@ -0,0 +1,16 @@
+/* File:     bloom.h
+ * Purpose:  Header file for bloom.c, which implements a counting Bloom
+ *           filter that can be shared by threads.
+ */
+#ifndef _BLOOM_H_
+#define _BLOOM_H_
+
+struct bloom_s;
+
+struct bloom_s* Bloom_init(int expected_keys);
+void Bloom_add(struct bloom_s* bloom_p, int key);
+void Bloom_remove(struct bloom_s* bloom_p, int key);
+int  Bloom_maybe(struct bloom_s* bloom_p, int key);
+void Bloom_destroy(struct bloom_s* bloom_p);
+
+#endif
@@ -0,0 +1,796 @@
+/* File:     bptree.c
+ *
+ * Purpose:  Implement a sorted set of ints with ops insert, print,
+ *           member, delete, free_list.  The commands, output and
+ *           functions are the same as in linked_list.c, but the set
+ *           is stored in a B+ tree, so each op takes O(log n) time.
+ *
+ * Input:    Single character lower case letters to indicate operators,
+ *           followed by arguments needed by operators.
+ * Output:   Results of operations.
+ *
+ * Compile:  gcc -g -Wall -o bptree bptree.c oplog.c
+ * Run:      ./bptree [r <file> | p <file>]
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the set
+ *    2.  Int input isn't checked for errors.
+ *    3.  The b command carries out a batch of ops:  it's followed by
+ *        the op (i, m, or d), the number of values, and the values.
+ *        The output is the same as the output of linked_list.c.
+ *    4.  With r <file>, the commands and their arguments are recorded
+ *        in file, and with p <file> they're replayed from file (see
+ *        oplog.c).  So a trace recorded by linked_list.c can be
+ *        replayed by this program, and the output should be the same.
+ *        The tree doesn't need compacting, so linked_list.c's c
+ *        command just prints the same message, with the number of
+ *        values in the set.
+ *    5.  At the end of stdin, the program acts as if q was entered.
+ *    6.  The values are stored in the leaves, in increasing order,
+ *        and the leaves are linked, so Print just follows the chain
+ *        of leaves.  An internal node with count keys has count+1
+ *        children:  the values in children[j] are less than keys[j],
+ *        and the values in children[j+1] are greater than or equal to
+ *        keys[j].
+ *    7.  A leaf takes one 64 byte cache line, and an internal node
+ *        takes two, so a search touches about two lines per level.
+ *        All the leaves are at the same depth, so the nodes don't
+ *        need a flag saying whether they're leaves:  the functions
+ *        keep track of the height instead.
+ *    8.  A full node is split in two when a value is inserted into it.
+ *        When a delete leaves a node with fewer than half the maximum
+ *        number of keys, it borrows a key from a sibling, or, if the
+ *        siblings are also half full, it's merged with one of them.
+ *        So every node except the root is at least half full.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "oplog.h"
+
+#define CACHE_LINE 64
+#define LEAF_MAX 13          /* Most values in a leaf */
+#define LEAF_MIN (LEAF_MAX/2)
+#define INNER_MAX 9          /* Most keys in an internal node */
+#define INNER_MIN (INNER_MAX/2)
+
+struct leaf_s {
+   int    count;
+   int    keys[LEAF_MAX];
+   struct leaf_s* next;
+} __attribute__((aligned(CACHE_LINE)));
+
+struct inner_s {
+   int    count;
+   int    keys[INNER_MAX];
+   void*  children[INNER_MAX+1];
+} __attribute__((aligned(CACHE_LINE)));
+
+struct bptree_s {
+   void*  root;
+   int    height;            /* 0 if the root is a leaf */
+};
+
+/* Logs for recording and replaying commands (see oplog.c) */
+struct oplog_s* record_log = NULL;
+struct oplog_s* replay_log = NULL;
+
+int  Insert(int value, struct bptree_s* tree_p);
+void Print(struct bptree_s* tree_p);
+int  Size(struct bptree_s* tree_p);
+int  Member(int value, struct bptree_s* tree_p);
+int  Delete(int value, struct bptree_s* tree_p);
+void Free_list(struct bptree_s* tree_p);
+int  Is_empty(struct bptree_s* tree_p);
+void Batch(struct bptree_s* tree_p);
+int  Compare(const void* x_p, const void* y_p);
+
+int  Tree_insert(int value, struct bptree_s* tree_p);
+int  Tree_member(int value, struct bptree_s* tree_p);
+int  Tree_delete(int value, struct bptree_s* tree_p);
+int  Insert_rec(void* node, int height, int value, int* up_key_p,
+        void** new_node_p);
+int  Delete_rec(void* node, int height, int value);
+void Fix_child(struct inner_s* parent_p, int i, int height);
+void Fix_leaf(struct inner_s* parent_p, int i);
+void Fix_inner(struct inner_s* parent_p, int i);
+void Remove_child(struct inner_s* parent_p, int i);
+int  Child_index(struct inner_s* inner_p, int value);
+void Free_rec(void* node, int height);
+struct leaf_s*  Allocate_leaf(void);
+struct inner_s* Allocate_inner(void);
+
+void Usage(char* prog_name);
+char Get_command(void);
+int  Get_value(void);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   char command;
+   int  value;
+   struct bptree_s tree = {NULL, 0};  /* start with empty set */
+
+   if (argc == 3 && argv[1][0] == 'r')
+      record_log = Oplog_create(argv[2]);
+   else if (argc == 3 && argv[1][0] == 'p')
+      replay_log = Oplog_open(argv[2]);
+   else if (argc != 1)
+      Usage(argv[0]);
+
+   command = Get_command();
+   while (command != 'q' && command != 'Q') {
+      switch (command) {
+         case 'i':
+         case 'I':
+            value = Get_value();
+            Insert(value, &tree);  /* Ignore return value */
+            break;
+         case 'p':
+         case 'P':
+            Print(&tree);
+            break;
+         case 'm':
+         case 'M':
+            value = Get_value();
+            Member(value, &tree);  /* Ignore return value */
+            break;
+         case 'd':
+         case 'D':
+            value = Get_value();
+            Delete(value, &tree);  /* Ignore return value */
+            break;
+         case 'b':
+         case 'B':
+            Batch(&tree);
+            break;
+         case 'c':
+         case 'C':
+            /* Nothing to compact:  match linked_list.c's output */
+            printf("Compacted %d nodes\n", Size(&tree));
+            break;
+         default:
+            printf("There is no %c command\n", command);
+            printf("Please try again\n");
+      }
+      command = Get_command();
+   }
+   Free_list(&tree);
+
+   if (record_log != NULL) Oplog_close(record_log);
+   if (replay_log != NULL) Oplog_close(replay_log);
+
+   return 0;
+}  /* main */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Usage
+ * Purpose:    Print a message showing the command line arguments
+ *             and quit
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s [r <file> | p <file>]\n", prog_name);
+   fprintf(stderr, "   r:  record the commands in file\n");
+   fprintf(stderr, "   p:  replay the commands recorded in file\n");
+   exit(0);
+}  /* Usage */
+
+
+/*-----------------------------------------------------------------*/
+/* Function:   Insert
+ * Purpose:    Insert value into the set.  If value is already in the
+ *             set, print a message and return
+ * In arg:     value, the value to be inserted
+ * In/out arg: tree_p, pointer to the tree
+ * Return val: 1 if value was inserted, 0 otherwise
+ */
+int Insert(int value, struct bptree_s* tree_p) {
+   if (Tree_insert(value, tree_p)) {
+      return 1;
+   } else {
+      printf("%d is already in the list\n", value);
+      return 0;
+   }
+}  /* Insert */
+
+/*-----------------------------------------------------------------*/
+/* Function:  Print
+ * Purpose:   Print the values in the set in increasing order by
+ *            following the chain of leaves
+ * In arg:    tree_p, pointer to the tree
+ */
+void Print(struct bptree_s* tree_p) {
+   void* node = tree_p->root;
+   struct leaf_s* leaf_p;
+   int h, j;
+
+   printf("list = ");
+
+   for (h = tree_p->height; h > 0; h--)
+      node = ((struct inner_s*) node)->children[0];
+   for (leaf_p = node; leaf_p != NULL; leaf_p = leaf_p->next)
+      for (j = 0; j < leaf_p->count; j++)
+         printf("%d ", leaf_p->keys[j]);
+   printf("\n");
+}  /* Print */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Size
+ * Purpose:    Count the values in the set
+ * In arg:     tree_p, pointer to the tree
+ */
+int Size(struct bptree_s* tree_p) {
+   void* node = tree_p->root;
+   struct leaf_s* leaf_p;
+   int h, size = 0;
+
+   for (h = tree_p->height; h > 0; h--)
+      node = ((struct inner_s*) node)->children[0];
+   for (leaf_p = node; leaf_p != NULL; leaf_p = leaf_p->next)
+      size += leaf_p->count;
+   return size;
+}  /* Size */
+
+
+/*-----------------------------------------------------------------*/
+/* Function:    Member
+ * Purpose:     Search the set for value
+ * In args:     value, the value to be searched for
+ *              tree_p, pointer to the tree
+ * Return val:  true, if value is in the set, false otherwise
+ */
+int  Member(int value, struct bptree_s* tree_p) {
+   if (Tree_member(value, tree_p)) {
+      printf("%d is in the list\n", value);
+      return 1;
+   } else {
+      printf("%d is not in the list\n", value);
+      return 0;
+   }
+}  /* Member */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Delete
+ * Purpose:     If value is in the set, delete it.  Otherwise, print
+ *              a message and return.
+ * In arg:      value, the value to be deleted
+ * In/out arg:  tree_p, pointer to the tree
+ * Return val:  1 if value is deleted, 0 otherwise
+ */
+int Delete(int value, struct bptree_s* tree_p) {
+   if (Tree_delete(value, tree_p)) {
+      return 1;
+   } else {
+      printf("%d is not in the list\n", value);
+      return 0;
+   }
+}  /* Delete */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Batch
+ * Purpose:     Read an op, the number of values, and the values from
+ *              stdin, and carry out the op on all the values
+ * In/out arg:  tree_p, pointer to the tree
+ * Note:        The values are sorted first, so that consecutive ops
+ *              use the same nodes
+ */
+void Batch(struct bptree_s* tree_p) {
+   char op;
+   int  i, n, count = 0;
+   int* values;
+
+   op = Get_command();
+   if (replay_log != NULL) {
+      n = Oplog_get_int(replay_log);
+   } else {
+      printf("How many values?  ");
+      scanf("%d", &n);
+      if (record_log != NULL) Oplog_put_int(record_log, n);
+   }
+   if (n <= 0) return;
+   values = malloc(n*sizeof(int));
+   for (i = 0; i < n; i++)
+      values[i] = Get_value();
+   qsort(values, n, sizeof(int), Compare);
+
+   switch (op) {
+      case 'i':
+      case 'I':
+         for (i = 0; i < n; i++)
+            count += Tree_insert(values[i], tree_p);
+         printf("Inserted %d of %d values\n", count, n);
+         break;
+      case 'm':
+      case 'M':
+         for (i = 0; i < n; i++)
+            if (i == 0 || values[i] != values[i-1])
+               count += Tree_member(values[i], tree_p);
+         printf("%d of %d values are in the list\n", count, n);
+         break;
+      case 'd':
+      case 'D':
+         for (i = 0; i < n; i++)
+            count += Tree_delete(values[i], tree_p);
+         printf("Deleted %d of %d values\n", count, n);
+         break;
+      default:
+         printf("There is no batch %c command\n", op);
+   }
+   free(values);
+}  /* Batch */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Compare
+ * Purpose:     Compare two ints, for use by qsort
+ * In args:     x_p, y_p
+ * Return val:  -1 if *x_p < *y_p, 0 if *x_p == *y_p, 1 otherwise
+ */
+int Compare(const void* x_p, const void* y_p) {
+   int x = *((int*)x_p);
+   int y = *((int*)y_p);
+
+   if (x < y)
+      return -1;
+   else if (x == y)
+      return 0;
+   else /* x > y */
+      return 1;
+}  /* Compare */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Tree_insert
+ * Purpose:     Insert value into the tree without printing anything.
+ *              If the root splits, the tree gets a new root.
+ * Return val:  1 if value was inserted, 0 if it was already there
+ */
+int Tree_insert(int value, struct bptree_s* tree_p) {
+   struct leaf_s* leaf_p;
+   struct inner_s* root_p;
+   void* new_node;
+   int up_key, rv;
+
+   if (tree_p->root == NULL) {
+      leaf_p = Allocate_leaf();
+      leaf_p->count = 1;
+      leaf_p->keys[0] = value;
+      tree_p->root = leaf_p;
+      tree_p->height = 0;
+      return 1;
+   }
+
+   rv = Insert_rec(tree_p->root, tree_p->height, value, &up_key, &new_node);
+   if (new_node != NULL) {
+      root_p = Allocate_inner();
+      root_p->count = 1;
+      root_p->keys[0] = up_key;
+      root_p->children[0] = tree_p->root;
+      root_p->children[1] = new_node;
+      tree_p->root = root_p;
+      tree_p->height++;
+   }
+   return rv;
+}  /* Tree_insert */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Tree_member
+ * Purpose:     Search the tree for value without printing anything
+ * Return val:  1 if value is in the tree, 0 otherwise
+ */
+int Tree_member(int value, struct bptree_s* tree_p) {
+   void* node = tree_p->root;
+   struct leaf_s* leaf_p;
+   int h, j;
+
+   if (node == NULL) return 0;
+   for (h = tree_p->height; h > 0; h--)
+      node = ((struct inner_s*) node)->children[Child_index(node, value)];
+   leaf_p = node;
+   for (j = 0; j < leaf_p->count && leaf_p->keys[j] < value; j++)
+      ;
+   return j < leaf_p->count && leaf_p->keys[j] == value;
+}  /* Tree_member */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Tree_delete
+ * Purpose:     Delete value from the tree without printing anything.
+ *              If the root is left with only one child, the child
+ *              becomes the root.
+ * Return val:  1 if value was deleted, 0 if it wasn't in the tree
+ */
+int Tree_delete(int value, struct bptree_s* tree_p) {
+   struct inner_s* root_p;
+   int rv;
+
+   if (tree_p->root == NULL) return 0;
+   rv = Delete_rec(tree_p->root, tree_p->height, value);
+
+   if (tree_p->height > 0) {
+      root_p = tree_p->root;
+      if (root_p->count == 0) {
+         tree_p->root = root_p->children[0];
+         tree_p->height--;
+         free(root_p);
+      }
+   } else if (((struct leaf_s*) tree_p->root)->count == 0) {
+      free(tree_p->root);
+      tree_p->root = NULL;
+   }
+   return rv;
+}  /* Tree_delete */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Insert_rec
+ * Purpose:     Insert value into the subtree rooted at node
+ * In args:     node, height (0 for a leaf), value
+ * Out args:    new_node_p:  if node was split, the new node to its
+ *                 right, and NULL otherwise
+ *              up_key_p:  if node was split, the smallest value in the
+ *                 subtree rooted at *new_node_p
+ * Return val:  1 if value was inserted, 0 if it was already there
+ */
+int Insert_rec(void* node, int height, int value, int* up_key_p,
+      void** new_node_p) {
+   struct leaf_s* leaf_p;
+   struct leaf_s* right_leaf_p;
+   struct inner_s* inner_p;
+   struct inner_s* right_p;
+   int keys[LEAF_MAX+1];     /* LEAF_MAX >= INNER_MAX */
+   void* children[INNER_MAX+2];
+   void* new_child;
+   int i, j, child_key, rv, left_count;
+
+   *new_node_p = NULL;
+   if (height == 0) {
+      leaf_p = node;
+      for (i = 0; i < leaf_p->count && leaf_p->keys[i] < value; i++)
+         ;
+      if (i < leaf_p->count && leaf_p->keys[i] == value) return 0;
+
+      if (leaf_p->count < LEAF_MAX) {
+         for (j = leaf_p->count; j > i; j--)
+            leaf_p->keys[j] = leaf_p->keys[j-1];
+         leaf_p->keys[i] = value;
+         leaf_p->count++;
+         return 1;
+      }
+
+      /* Split the full leaf:  copy its values and the new value */
+      /* to keys, and divide them between the two leaves         */
+      for (j = 0; j < i; j++) keys[j] = leaf_p->keys[j];
+      keys[i] = value;
+      for (j = i; j < LEAF_MAX; j++) keys[j+1] = leaf_p->keys[j];
+      right_leaf_p = Allocate_leaf();
+      left_count = (LEAF_MAX + 1)/2;
+      leaf_p->count = left_count;
+      right_leaf_p->count = LEAF_MAX + 1 - left_count;
+      for (j = 0; j < left_count; j++)
+         leaf_p->keys[j] = keys[j];
+      for (j = 0; j < right_leaf_p->count; j++)
+         right_leaf_p->keys[j] = keys[left_count + j];
+      right_leaf_p->next = leaf_p->next;
+      leaf_p->next = right_leaf_p;
+      *up_key_p = right_leaf_p->keys[0];
+      *new_node_p = right_leaf_p;
+      return 1;
+   }
+
+   inner_p = node;
+   i = Child_index(inner_p, value);
+   rv = Insert_rec(inner_p->children[i], height - 1, value, &child_key,
+         &new_child);
+   if (new_child == NULL) return rv;
+
+   if (inner_p->count < INNER_MAX) {
+      for (j = inner_p->count; j > i; j--) {
+         inner_p->keys[j] = inner_p->keys[j-1];
+         inner_p->children[j+1] = inner_p->children[j];
+      }
+      inner_p->keys[i] = child_key;
+      inner_p->children[i+1] = new_child;
+      inner_p->count++;
+      return rv;
+   }
+
+   /* Split the full internal node.  The middle key moves up. */
+   for (j = 0; j < i; j++) keys[j] = inner_p->keys[j];
+   keys[i] = child_key;
+   for (j = i; j < INNER_MAX; j++) keys[j+1] = inner_p->keys[j];
+   for (j = 0; j <= i; j++) children[j] = inner_p->children[j];
+   children[i+1] = new_child;
+   for (j = i + 1; j <= INNER_MAX; j++) children[j+1] = inner_p->children[j];
+
+   right_p = Allocate_inner();
+   left_count = (INNER_MAX + 1)/2;
+   inner_p->count = left_count;
+   right_p->count = INNER_MAX - left_count;
+   for (j = 0; j < left_count; j++) {
+      inner_p->keys[j] = keys[j];
+      inner_p->children[j] = children[j];
+   }
+   inner_p->children[left_count] = children[left_count];
+   for (j = 0; j < right_p->count; j++) {
+      right_p->keys[j] = keys[left_count + 1 + j];
+      right_p->children[j] = children[left_count + 1 + j];
+   }
+   right_p->children[right_p->count] = children[INNER_MAX + 1];
+   *up_key_p = keys[left_count];
+   *new_node_p = right_p;
+   return rv;
+}  /* Insert_rec */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Delete_rec
+ * Purpose:     Delete value from the subtree rooted at node.  If a
+ *              child of node is left less than half full, fix it.
+ * In args:     node, height (0 for a leaf), value
+ * Return val:  1 if value was deleted, 0 if it wasn't in the subtree
+ * Note:        node itself may be left less than half full:  its
+ *              parent fixes it.
+ */
+int Delete_rec(void* node, int height, int value) {
+   struct leaf_s* leaf_p;
+   struct inner_s* inner_p;
+   int i, j, rv;
+
+   if (height == 0) {
+      leaf_p = node;
+      for (i = 0; i < leaf_p->count && leaf_p->keys[i] < value; i++)
+         ;
+      if (i == leaf_p->count || leaf_p->keys[i] != value) return 0;
+      for (j = i; j < leaf_p->count - 1; j++)
+         leaf_p->keys[j] = leaf_p->keys[j+1];
+      leaf_p->count--;
+      return 1;
+   }
+
+   inner_p = node;
+   i = Child_index(inner_p, value);
+   rv = Delete_rec(inner_p->children[i], height - 1, value);
+   if (rv) Fix_child(inner_p, i, height - 1);
+   return rv;
+}  /* Delete_rec */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Fix_child
+ * Purpose:     If children[i] of parent is less than half full, borrow
+ *              a key from one of its siblings or merge it with one
+ * In args:     i, height of the child (0 for a leaf)
+ * In/out arg:  parent_p
+ */
+void Fix_child(struct inner_s* parent_p, int i, int height) {
+   if (height == 0) {
+      if (((struct leaf_s*) parent_p->children[i])->count < LEAF_MIN)
+         Fix_leaf(parent_p, i);
+   } else {
+      if (((struct inner_s*) parent_p->children[i])->count < INNER_MIN)
+         Fix_inner(parent_p, i);
+   }
+}  /* Fix_child */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Fix_leaf
+ * Purpose:     Rebalance the leaf children[i] of parent, which has
+ *              LEAF_MIN - 1 values
+ */
+void Fix_leaf(struct inner_s* parent_p, int i) {
+   struct leaf_s* leaf_p = parent_p->children[i];
+   struct leaf_s* left_p = (i > 0) ? parent_p->children[i-1] : NULL;
+   struct leaf_s* right_p = (i < parent_p->count) ?
+      parent_p->children[i+1] : NULL;
+   int j;
+
+   if (left_p != NULL && left_p->count > LEAF_MIN) {
+      /* Borrow the largest value in the left sibling */
+      for (j = leaf_p->count; j > 0; j--)
+         leaf_p->keys[j] = leaf_p->keys[j-1];
+      leaf_p->keys[0] = left_p->keys[left_p->count - 1];
+      leaf_p->count++;
+      left_p->count--;
+      parent_p->keys[i-1] = leaf_p->keys[0];
+   } else if (right_p != NULL && right_p->count > LEAF_MIN) {
+      /* Borrow the smallest value in the right sibling */
+      leaf_p->keys[leaf_p->count] = right_p->keys[0];
+      leaf_p->count++;
+      for (j = 0; j < right_p->count - 1; j++)
+         right_p->keys[j] = right_p->keys[j+1];
+      right_p->count--;
+      parent_p->keys[i] = right_p->keys[0];
+   } else {
+      /* Merge with a sibling:  the right one of the pair is freed */
+      if (left_p != NULL) {
+         right_p = leaf_p;
+         leaf_p = left_p;
+         i--;
+      }
+      for (j = 0; j < right_p->count; j++)
+         leaf_p->keys[leaf_p->count + j] = right_p->keys[j];
+      leaf_p->count += right_p->count;
+      leaf_p->next = right_p->next;
+      free(right_p);
+      Remove_child(parent_p, i);
+   }
+}  /* Fix_leaf */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Fix_inner
+ * Purpose:     Rebalance the internal node children[i] of parent,
+ *              which has INNER_MIN - 1 keys
+ */
+void Fix_inner(struct inner_s* parent_p, int i) {
+   struct inner_s* node_p = parent_p->children[i];
+   struct inner_s* left_p = (i > 0) ? parent_p->children[i-1] : NULL;
+   struct inner_s* right_p = (i < parent_p->count) ?
+      parent_p->children[i+1] : NULL;
+   int j;
+
+   if (left_p != NULL && left_p->count > INNER_MIN) {
+      /* Rotate right:  the separator moves down into node, and the */
+      /* left sibling's largest key moves up                        */
+      node_p->children[node_p->count + 1] = node_p->children[node_p->count];
+      for (j = node_p->count; j > 0; j--) {
+         node_p->keys[j] = node_p->keys[j-1];
+         node_p->children[j] = node_p->children[j-1];
+      }
+      node_p->keys[0] = parent_p->keys[i-1];
+      node_p->children[0] = left_p->children[left_p->count];
+      node_p->count++;
+      parent_p->keys[i-1] = left_p->keys[left_p->count - 1];
+      left_p->count--;
+   } else if (right_p != NULL && right_p->count > INNER_MIN) {
+      /* Rotate left */
+      node_p->keys[node_p->count] = parent_p->keys[i];
+      node_p->children[node_p->count + 1] = right_p->children[0];
+      node_p->count++;
+      parent_p->keys[i] = right_p->keys[0];
+      for (j = 0; j < right_p->count - 1; j++) {
+         right_p->keys[j] = right_p->keys[j+1];
+         right_p->children[j] = right_p->children[j+1];
+      }
+      right_p->children[right_p->count - 1] =
+         right_p->children[right_p->count];
+      right_p->count--;
+   } else {
+      /* Merge with a sibling.  The separator moves down between    */
+      /* the two nodes' keys, and the right one of the pair is freed */
+      if (left_p != NULL) {
+         right_p = node_p;
+         node_p = left_p;
+         i--;
+      }
+      node_p->keys[node_p->count] = parent_p->keys[i];
+      for (j = 0; j < right_p->count; j++) {
+         node_p->keys[node_p->count + 1 + j] = right_p->keys[j];
+         node_p->children[node_p->count + 1 + j] = right_p->children[j];
+      }
+      node_p->children[node_p->count + 1 + right_p->count] =
+         right_p->children[right_p->count];
+      node_p->count += 1 + right_p->count;
+      free(right_p);
+      Remove_child(parent_p, i);
+   }
+}  /* Fix_inner */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Remove_child
+ * Purpose:     Remove keys[i] and children[i+1] from parent after
+ *              children[i+1] has been merged into children[i]
+ */
+void Remove_child(struct inner_s* parent_p, int i) {
+   int j;
+
+   for (j = i; j < parent_p->count - 1; j++) {
+      parent_p->keys[j] = parent_p->keys[j+1];
+      parent_p->children[j+1] = parent_p->children[j+2];
+   }
+   parent_p->count--;
+}  /* Remove_child */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Child_index
+ * Purpose:     Find the child of an internal node whose subtree
+ *              should contain value
+ * Return val:  The number of keys that are <= value
+ */
+int Child_index(struct inner_s* inner_p, int value) {
+   int i;
+
+   for (i = 0; i < inner_p->count && inner_p->keys[i] <= value; i++)
+      ;
+   return i;
+}  /* Child_index */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Allocate_leaf
+ * Purpose:    Get storage for an empty leaf that starts on a cache
+ *             line
+ */
+struct leaf_s* Allocate_leaf(void) {
+   struct leaf_s* leaf_p = aligned_alloc(CACHE_LINE, sizeof(struct leaf_s));
+
+   leaf_p->count = 0;
+   leaf_p->next = NULL;
+   return leaf_p;
+}  /* Allocate_leaf */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Allocate_inner
+ * Purpose:    Get storage for an empty internal node that starts on a
+ *             cache line
+ */
+struct inner_s* Allocate_inner(void) {
+   struct inner_s* inner_p =
+      aligned_alloc(CACHE_LINE, sizeof(struct inner_s));
+
+   inner_p->count = 0;
+   return inner_p;
+}  /* Allocate_inner */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Free_list
+ * Purpose:    Free the storage used by the tree
+ * In/out arg: tree_p, pointer to the tree.  It's empty on return.
+ */
+void Free_list(struct bptree_s* tree_p) {
+   if (Is_empty(tree_p)) return;
+   Free_rec(tree_p->root, tree_p->height);
+   tree_p->root = NULL;
+   tree_p->height = 0;
+}  /* Free_list */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Free_rec
+ * Purpose:    Free the subtree rooted at node
+ */
+void Free_rec(void* node, int height) {
+   struct inner_s* inner_p = node;
+   int j;
+
+   if (height > 0)
+      for (j = 0; j <= inner_p->count; j++)
+         Free_rec(inner_p->children[j], height - 1);
+   free(node);
+}  /* Free_rec */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Is_empty
+ * Purpose:     Determine whether the set is empty
+ * In arg:      tree_p, pointer to the tree
+ * Return val:  true, if the tree has no nodes, false otherwise
+ */
+int  Is_empty(struct bptree_s* tree_p) {
+   if (tree_p->root == NULL)
+      return 1;
+   else
+      return 0;
+}  /* Is_empty */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Get_command
+ * Purpose:     Get the next command (a single char) from stdin, or
+ *              from the log that's being replayed
+ * Return val:  The next nonwhite char in stdin
+ */
+char Get_command(void) {
+   char c;
+
+   if (replay_log != NULL) return Oplog_get_op(replay_log);
+   printf("Please enter a command:  ");
+   /* Put the space before the %c so scanf will skip white space */
+   if (scanf(" %c", &c) != 1) c = 'q';  /* End of input */
+   if (record_log != NULL) Oplog_put_op(record_log, c);
+   return c;
+}  /* Get_command */
+
+/*-----------------------------------------------------------------*/
+/* Function;      Get_value
+ * Purpose:       Get an int from stdin, or from the log that's being
+ *                replayed
+ * Return value:  The int
+ */
+int  Get_value(void) {
+   int val;
+
+   if (replay_log != NULL) return Oplog_get_int(replay_log);
+   printf("Please enter a value:  ");
+   scanf("%d", &val);
+   if (record_log != NULL) Oplog_put_int(record_log, val);
+   return val;
+}  /* Get_value */
@@ -0,0 +1,140 @@
+/* File:     br_rwlock.c
+ *
+ * Purpose:  Implement a reader-biased ("big reader") read-write lock.
+ *           Each thread has its own reader indicator on its own cache
+ *           line, so readers don't write to any shared cache line:
+ *           acquiring and releasing a read lock only touches the
+ *           reader's indicator and reads the writer flag.
+ *
+ * Br_init:      allocate a lock for thread_count threads
+ * Br_rdlock:    acquire the lock for reading.  rank is the calling
+ *               thread's rank, 0 <= rank < thread_count
+ * Br_rdunlock:  release a read lock
+ * Br_wrlock:    acquire the lock for writing
+ * Br_wrunlock:  release a write lock
+ * Br_destroy:   free the lock
+ *
+ * Notes:
+ * 1.  Writers are serialized by a mutex.  A writer sets the writer
+ *     flag and then waits for every reader indicator to be clear.
+ * 2.  A reader sets its indicator and then checks the writer flag.
+ *     If the flag is set, the reader clears its indicator and waits
+ *     for the flag to be cleared.  So once a writer has announced
+ *     itself, no new readers get in:  writers have preference and
+ *     can't be starved by a stream of readers.
+ * 3.  Both sides use sequentially consistent stores and loads, so a
+ *     reader and a writer can't both miss each other's flag.
+ * 4.  Waiting threads spin for a while and then call sched_yield,
+ *     so the lock still makes progress when there are more threads
+ *     than cores (see spin.h).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "br_rwlock.h"
+#include "spin.h"
+
+#define CACHE_LINE 64
+
+struct reader_s {
+   int active;
+} __attribute__((aligned(CACHE_LINE)));
+
+struct br_rwlock_s {
+   int              writer __attribute__((aligned(CACHE_LINE)));
+   pthread_mutex_t  writer_mutex;
+   int              thread_count;
+   struct reader_s* readers;
+};
+
+
+/*-----------------------------------------------------------------*/
+/* Function:   Br_init
+ * Purpose:    Allocate and initialize a lock
+ * In arg:     thread_count, the number of threads that can read
+ * Return val: Pointer to the lock
+ */
+struct br_rwlock_s* Br_init(int thread_count) {
+   struct br_rwlock_s* lock_p;
+   int i;
+
+   lock_p = aligned_alloc(CACHE_LINE, sizeof(struct br_rwlock_s));
+   lock_p->writer = 0;
+   pthread_mutex_init(&lock_p->writer_mutex, NULL);
+   lock_p->thread_count = thread_count;
+   lock_p->readers = aligned_alloc(CACHE_LINE,
+         thread_count*sizeof(struct reader_s));
+   for (i = 0; i < thread_count; i++)
+      lock_p->readers[i].active = 0;
+   return lock_p;
+}  /* Br_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Br_rdlock
+ * Purpose:    Acquire the lock for reading
+ * In args:    lock_p, rank
+ */
+void Br_rdlock(struct br_rwlock_s* lock_p, int rank) {
+   int* active_p = &lock_p->readers[rank].active;
+   int spins;
+
+   while (1) {
+      __atomic_store_n(active_p, 1, __ATOMIC_SEQ_CST);
+      if (!__atomic_load_n(&lock_p->writer, __ATOMIC_SEQ_CST))
+         return;
+
+      /* A writer is waiting or active:  back off */
+      __atomic_store_n(active_p, 0, __ATOMIC_RELEASE);
+      spins = 0;
+      while (__atomic_load_n(&lock_p->writer, __ATOMIC_ACQUIRE))
+         Spin_pause(&spins);
+   }
+}  /* Br_rdlock */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Br_rdunlock
+ * Purpose:    Release a read lock
+ * In args:    lock_p, rank
+ */
+void Br_rdunlock(struct br_rwlock_s* lock_p, int rank) {
+   __atomic_store_n(&lock_p->readers[rank].active, 0, __ATOMIC_RELEASE);
+}  /* Br_rdunlock */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Br_wrlock
+ * Purpose:    Acquire the lock for writing:  announce the writer,
+ *             then wait for the readers to drain
+ * In arg:     lock_p
+ */
+void Br_wrlock(struct br_rwlock_s* lock_p) {
+   int i, spins;
+
+   pthread_mutex_lock(&lock_p->writer_mutex);
+   __atomic_store_n(&lock_p->writer, 1, __ATOMIC_SEQ_CST);
+   for (i = 0; i < lock_p->thread_count; i++) {
+      spins = 0;
+      while (__atomic_load_n(&lock_p->readers[i].active, __ATOMIC_SEQ_CST))
+         Spin_pause(&spins);
+   }
+}  /* Br_wrlock */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Br_wrunlock
+ * Purpose:    Release a write lock
+ * In arg:     lock_p
+ */
+void Br_wrunlock(struct br_rwlock_s* lock_p) {
+   __atomic_store_n(&lock_p->writer, 0, __ATOMIC_RELEASE);
+   pthread_mutex_unlock(&lock_p->writer_mutex);
+}  /* Br_wrunlock */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Br_destroy
+ * Purpose:    Free the storage used by a lock
+ * In arg:     lock_p
+ */
+void Br_destroy(struct br_rwlock_s* lock_p) {
+   pthread_mutex_destroy(&lock_p->writer_mutex);
+   free(lock_p->readers);
+   free(lock_p);
+}  /* Br_destroy */
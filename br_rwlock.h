@@ -0,0 +1,18 @@
+/* File:     br_rwlock.h
+ * Purpose:  Header file for br_rwlock.c, which implements a reader-
+ *           biased ("big reader") read-write lock with a separate
+ *           reader indicator for each thread.
+ */
+#ifndef _BR_RWLOCK_H_
+#define _BR_RWLOCK_H_
+
+struct br_rwlock_s;
+
+struct br_rwlock_s* Br_init(int thread_count);
+void Br_rdlock(struct br_rwlock_s* lock_p, int rank);
+void Br_rdunlock(struct br_rwlock_s* lock_p, int rank);
+void Br_wrlock(struct br_rwlock_s* lock_p);
+void Br_wrunlock(struct br_rwlock_s* lock_p);
+void Br_destroy(struct br_rwlock_s* lock_p);
+
+#endif
@@ -0,0 +1,228 @@
+/* File:     epoch.c
+ *
+ * Purpose:  Implement epoch-based reclamation (EBR) of memory that is
+ *           shared by threads, so that a thread can unlink a node from
+ *           a shared data structure without knowing whether other
+ *           threads are still reading it.
+ *
+ * Epoch_init:      allocate a slot for each of thread_count threads and
+ *                  the main thread.  free_fn is used to free retired
+ *                  memory (e.g. free)
+ * Epoch_register:  associate the calling thread with slot rank.  Ranks
+ *                  are 0, 1, ..., thread_count-1;  the main thread should
+ *                  use rank thread_count
+ * Epoch_enter:     start a read-side critical section:  pointers into
+ *                  the shared structure may only be held between
+ *                  Epoch_enter and Epoch_exit
+ * Epoch_exit:      end a read-side critical section
+ * Epoch_retire:    p has been unlinked:  free it when no thread that
+ *                  might have a pointer to it is still in a critical
+ *                  section
+ * Epoch_destroy:   free everything that's still retired, and the slots.
+ *                  Only call this when the other threads are done.
+ *
+ * Notes:
+ * 1.  There is a global epoch counter.  A thread entering a critical
+ *     section records the current global epoch in its slot.  The global
+ *     epoch can only advance from e to e+1 when every thread that's in
+ *     a critical section has recorded e.
+ * 2.  Memory retired when the global epoch is e is put in a per-thread
+ *     "limbo" list for e.  Any thread that could have a pointer to
+ *     it entered its critical section in epoch e or earlier, so once
+ *     the global epoch reaches e+2 the memory can be freed.
+ * 3.  Each thread keeps three limbo lists, and the list for epoch e
+ *     reuses the list for epoch e-3.
+ * 4.  Threads are identified by a thread-local pointer to their slot,
+ *     so the list operations that call Epoch_enter, etc., don't need
+ *     a rank argument.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "epoch.h"
+
+#define CACHE_LINE 64
+#define LIMBO_LISTS 3
+/* A thread tries to advance the epoch after this many retires */
+#define RETIRE_BATCH 64
+
+struct limbo_s {
+   unsigned long epoch;
+   void**        ptrs;
+   int           count;
+   int           max;
+};
+
+/* Each slot is padded to its own cache lines */
+struct epoch_slot_s {
+   unsigned long  epoch;
+   int            active;
+   int            since_advance;
+   struct limbo_s limbo[LIMBO_LISTS];
+   char           pad[CACHE_LINE];
+} __attribute__((aligned(CACHE_LINE)));
+
+static unsigned long global_epoch __attribute__((aligned(CACHE_LINE))) = 0;
+static struct epoch_slot_s* slots = NULL;
+static int slot_count = 0;
+static void (*epoch_free)(void* p) = free;
+static __thread struct epoch_slot_s* my_slot = NULL;
+
+static void Free_limbo(struct limbo_s* limbo_p);
+static void Try_advance(void);
+static void Reclaim(struct epoch_slot_s* slot_p);
+
+/*-----------------------------------------------------------------*/
+/* Function:   Epoch_init
+ * Purpose:    Allocate and initialize the slots
+ * In args:    thread_count, free_fn
+ */
+void Epoch_init(int thread_count, void (*free_fn)(void* p)) {
+   int i, j;
+
+   slot_count = thread_count + 1;
+   slots = aligned_alloc(CACHE_LINE,
+         slot_count*sizeof(struct epoch_slot_s));
+   for (i = 0; i < slot_count; i++) {
+      slots[i].epoch = 0;
+      slots[i].active = 0;
+      slots[i].since_advance = 0;
+      for (j = 0; j < LIMBO_LISTS; j++) {
+         slots[i].limbo[j].epoch = 0;
+         slots[i].limbo[j].ptrs = NULL;
+         slots[i].limbo[j].count = slots[i].limbo[j].max = 0;
+      }
+   }
+   global_epoch = 0;
+   if (free_fn != NULL) epoch_free = free_fn;
+}  /* Epoch_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Epoch_register
+ * Purpose:    Associate the calling thread with a slot
+ * In arg:     rank
+ */
+void Epoch_register(int rank) {
+   if (rank < 0 || rank >= slot_count) {
+      fprintf(stderr, "Epoch_register:  bad rank %d\n", rank);
+      exit(-1);
+   }
+   my_slot = &slots[rank];
+}  /* Epoch_register */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Epoch_enter
+ * Purpose:    Start a read-side critical section
+ * Note:       The full fence makes sure that the slot is seen as
+ *             active before the caller loads any shared pointers.  It
+ *             pairs with the fence at the start of Try_advance:
+ *             either the reclaimer sees this slot as active, or the
+ *             reader sees the unlink that came before the retire.
+ */
+void Epoch_enter(void) {
+   __atomic_store_n(&my_slot->epoch,
+         __atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+   __atomic_store_n(&my_slot->active, 1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}  /* Epoch_enter */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Epoch_exit
+ * Purpose:    End a read-side critical section
+ */
+void Epoch_exit(void) {
+   __atomic_store_n(&my_slot->active, 0, __ATOMIC_RELEASE);
+}  /* Epoch_exit */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Epoch_retire
+ * Purpose:    Add p to the calling thread's limbo list for the current
+ *             global epoch.  Every RETIRE_BATCH calls, try to advance
+ *             the global epoch and free limbo lists that are safe.
+ * In arg:     p, memory that has already been unlinked
+ */
+void Epoch_retire(void* p) {
+   unsigned long e = __atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE);
+   struct limbo_s* limbo_p = &my_slot->limbo[e % LIMBO_LISTS];
+
+   if (limbo_p->epoch != e) {
+      /* limbo_p holds memory retired in epoch e-3 or earlier */
+      Free_limbo(limbo_p);
+      limbo_p->epoch = e;
+   }
+   if (limbo_p->count == limbo_p->max) {
+      limbo_p->max = (limbo_p->max == 0) ? RETIRE_BATCH : 2*limbo_p->max;
+      limbo_p->ptrs = realloc(limbo_p->ptrs, limbo_p->max*sizeof(void*));
+   }
+   limbo_p->ptrs[limbo_p->count++] = p;
+
+   if (++my_slot->since_advance >= RETIRE_BATCH) {
+      my_slot->since_advance = 0;
+      Try_advance();
+      Reclaim(my_slot);
+   }
+}  /* Epoch_retire */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Epoch_destroy
+ * Purpose:    Free all retired memory and the slots
+ */
+void Epoch_destroy(void) {
+   int i, j;
+
+   for (i = 0; i < slot_count; i++)
+      for (j = 0; j < LIMBO_LISTS; j++) {
+         Free_limbo(&slots[i].limbo[j]);
+         free(slots[i].limbo[j].ptrs);
+      }
+   free(slots);
+   slots = NULL;
+   slot_count = 0;
+}  /* Epoch_destroy */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Free_limbo
+ * Purpose:    Free the memory in a limbo list
+ */
+static void Free_limbo(struct limbo_s* limbo_p) {
+   int i;
+
+   for (i = 0; i < limbo_p->count; i++)
+      epoch_free(limbo_p->ptrs[i]);
+   limbo_p->count = 0;
+}  /* Free_limbo */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Try_advance
+ * Purpose:    Advance the global epoch if every active thread has
+ *             seen the current epoch
+ * Note:       The full fence orders the caller's unlinks before the
+ *             scan of the slots (see Epoch_enter)
+ */
+static void Try_advance(void) {
+   unsigned long e;
+   int i;
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   e = __atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE);
+
+   for (i = 0; i < slot_count; i++)
+      if (__atomic_load_n(&slots[i].active, __ATOMIC_ACQUIRE) &&
+            __atomic_load_n(&slots[i].epoch, __ATOMIC_RELAXED) != e)
+         return;
+   __atomic_compare_exchange_n(&global_epoch, &e, e+1, 0,
+         __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}  /* Try_advance */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Reclaim
+ * Purpose:    Free the limbo lists in a slot that are at least two
+ *             epochs old
+ */
+static void Reclaim(struct epoch_slot_s* slot_p) {
+   unsigned long e = __atomic_load_n(&global_epoch, __ATOMIC_ACQUIRE);
+   int j;
+
+   for (j = 0; j < LIMBO_LISTS; j++)
+      if (slot_p->limbo[j].epoch + 2 <= e)
+         Free_limbo(&slot_p->limbo[j]);
+}  /* Reclaim */
@@ -0,0 +1,15 @@
+/* File:     epoch.h
+ * Purpose:  Header file for epoch.c, which implements epoch-based
+ *           reclamation of memory shared by threads.
+ */
+#ifndef _EPOCH_H_
+#define _EPOCH_H_
+
+void Epoch_init(int thread_count, void (*free_fn)(void* p));
+void Epoch_register(int rank);
+void Epoch_enter(void);
+void Epoch_exit(void);
+void Epoch_retire(void* p);
+void Epoch_destroy(void);
+
+#endif
@@ -0,0 +1,144 @@
+/* File:     histogram.c
+ *
+ * Purpose:  Implement log-linear ("HDR") histograms of latencies, so
+ *           that a thread can cheaply record the time taken by each
+ *           op, and percentiles can be printed at the end of a run.
+ *
+ * Hist_init:        set all the counts to 0
+ * Hist_record:      add a value (e.g., a time in nanoseconds)
+ * Hist_merge:       add the counts in src_p to dest_p
+ * Hist_percentile:  return an upper bound on the p-th quantile of the
+ *                   recorded values, 0 <= p <= 1
+ * Hist_print:       print the count, mean, p50, p99, p99.9, and max
+ * Hist_now:         return the current time in nanoseconds
+ *
+ * Notes:
+ * 1.  Values less than 2*HIST_SUB are counted exactly.  Above that,
+ *     the values between 2^k and 2^(k+1) are split into HIST_SUB
+ *     equal buckets, so the relative error in a percentile is at most
+ *     1/HIST_SUB (about 3%), however large the values are.
+ * 2.  Hist_record only does a few shifts and increments a count, and
+ *     it doesn't use any locks:  each thread should record into its
+ *     own histogram, and the histograms should be merged after the
+ *     threads are done.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "histogram.h"
+
+static int           Bucket(unsigned long value);
+static unsigned long Bucket_max(int bucket);
+
+/*-----------------------------------------------------------------*/
+/* Function:   Hist_init
+ * Purpose:    Empty a histogram
+ */
+void Hist_init(struct histogram_s* hist_p) {
+   memset(hist_p, 0, sizeof(struct histogram_s));
+}  /* Hist_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Hist_record
+ * Purpose:    Add one value to a histogram
+ */
+void Hist_record(struct histogram_s* hist_p, unsigned long value) {
+   hist_p->count[Bucket(value)]++;
+   hist_p->total++;
+   hist_p->sum += value;
+   if (value > hist_p->max) hist_p->max = value;
+}  /* Hist_record */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Hist_merge
+ * Purpose:    Add the values in one histogram to another
+ */
+void Hist_merge(struct histogram_s* dest_p, struct histogram_s* src_p) {
+   int i;
+
+   for (i = 0; i < HIST_BUCKETS; i++)
+      dest_p->count[i] += src_p->count[i];
+   dest_p->total += src_p->total;
+   dest_p->sum += src_p->sum;
+   if (src_p->max > dest_p->max) dest_p->max = src_p->max;
+}  /* Hist_merge */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Hist_percentile
+ * Purpose:    Find the smallest bucket such that a fraction p of the
+ *             values are in it or in smaller buckets
+ * Return val: The largest value in that bucket, or the largest value
+ *             recorded, whichever is smaller
+ */
+unsigned long Hist_percentile(struct histogram_s* hist_p, double p) {
+   unsigned long target, so_far = 0;
+   unsigned long value;
+   int i;
+
+   if (hist_p->total == 0) return 0;
+   target = p*hist_p->total;
+   if (target < p*hist_p->total) target++;  /* Round up */
+   if (target == 0) target = 1;
+
+   for (i = 0; i < HIST_BUCKETS; i++) {
+      so_far += hist_p->count[i];
+      if (so_far >= target) break;
+   }
+   value = Bucket_max(i);
+   return (value < hist_p->max) ? value : hist_p->max;
+}  /* Hist_percentile */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Hist_print
+ * Purpose:    Print a one-line summary of a histogram of times in
+ *             nanoseconds
+ */
+void Hist_print(char* title, struct histogram_s* hist_p) {
+   printf("%s latency (ns):  count = %lu, mean = %.0f, p50 = %lu, "
+         "p99 = %lu, p99.9 = %lu, max = %lu\n", title, hist_p->total,
+         (hist_p->total > 0) ? hist_p->sum/hist_p->total : 0.0,
+         Hist_percentile(hist_p, 0.5), Hist_percentile(hist_p, 0.99),
+         Hist_percentile(hist_p, 0.999), hist_p->max);
+}  /* Hist_print */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Hist_now
+ * Purpose:    Read the monotonic clock
+ * Return val: The time in nanoseconds
+ */
+unsigned long Hist_now(void) {
+   struct timespec t;
+
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec*1000000000UL + t.tv_nsec;
+}  /* Hist_now */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Bucket
+ * Purpose:    Find the bucket that value belongs in.  If the most
+ *             significant bit of value is bit k >= HIST_SUB_BITS,
+ *             shift = k - HIST_SUB_BITS, and the top HIST_SUB_BITS+1
+ *             bits of value pick one of buckets shift*HIST_SUB + HIST_SUB,
+ *             ..., shift*HIST_SUB + 2*HIST_SUB - 1.
+ */
+static int Bucket(unsigned long value) {
+   int shift;
+
+   if (value < 2*HIST_SUB) return value;
+   shift = 63 - __builtin_clzl(value) - HIST_SUB_BITS;
+   return shift*HIST_SUB + (value >> shift);
+}  /* Bucket */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Bucket_max
+ * Purpose:    Find the largest value that belongs in a bucket
+ */
+static unsigned long Bucket_max(int bucket) {
+   int shift;
+   unsigned long top;
+
+   if (bucket < 2*HIST_SUB) return bucket;
+   shift = bucket/HIST_SUB - 1;
+   top = bucket - shift*HIST_SUB;
+   return ((top + 1) << shift) - 1;
+}  /* Bucket_max */
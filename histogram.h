@@ -0,0 +1,27 @@
+/* File:     histogram.h
+ * Purpose:  Header file for histogram.c, which implements log-linear
+ *           ("HDR") histograms of latencies.
+ */
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+/* Each power of 2 is split into 2^HIST_SUB_BITS buckets */
+#define HIST_SUB_BITS 5
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1)*HIST_SUB)
+
+struct histogram_s {
+   unsigned long count[HIST_BUCKETS];
+   unsigned long total;
+   unsigned long max;
+   double        sum;
+};
+
+void          Hist_init(struct histogram_s* hist_p);
+void          Hist_record(struct histogram_s* hist_p, unsigned long value);
+void          Hist_merge(struct histogram_s* dest_p, struct histogram_s* src_p);
+unsigned long Hist_percentile(struct histogram_s* hist_p, double p);
+void          Hist_print(char* title, struct histogram_s* hist_p);
+unsigned long Hist_now(void);
+
+#endif
@@ -7,38 +7,104 @@
  *           followed by arguments needed by operators.
  * Output:   Results of operations.
  *
- * Compile:  gcc -g -Wall -o linked_list linked_list.c
- * Run:      ./linked_list
+ * Compile:  gcc -g -Wall -o linked_list linked_list.c oplog.c
+ * Run:      ./linked_list [r <file> | p <file>]
  *
  * Notes:
  *    1.  Repeated values are not allowed in the list
  *    2.  DEBUG compile flag used.  To get debug output compile with
  *        -DDEBUG command line flag.
  *    3.  Int input isn't checked for errors.
+ *    4.  The b command carries out a batch of ops:  it's followed by
+ *        the op (i, m, or d), the number of values, and the values.
+ *        The values are sorted, and the whole batch is carried out
+ *        in a single pass over the list.
+ *    5.  Compile with -DNODE_POOL, and add node_pool.c to the command
+ *        line, to allocate list nodes from the pool in node_pool.c
+ *        instead of calling malloc and free.
+ *    6.  With r <file>, the commands and their arguments are recorded
+ *        in file as they're read.  With p <file>, they're replayed from
+ *        file instead of being read from stdin, and the prompts aren't
+ *        printed.  The file is a compact binary log (see oplog.c), so
+ *        a long trace can be replayed much faster than it can be
+ *        read with scanf.
+ *    7.  At the end of stdin, the program acts as if q was entered.
+ *    8.  After many inserts and deletes the nodes are scattered through
+ *        the heap, and following each next pointer is likely to be a
+ *        cache and TLB miss.  Compact copies the nodes, in key order,
+ *        into a new array (the arena), so a search reads consecutive
+ *        memory.  It's carried out by the c command, and automatically
+ *        when the number of nodes that aren't in the arena, plus the
+ *        number of holes left in the arena by deleted nodes, is more
+ *        than COMPACT_PERCENT percent of the list.  So an insert or
+ *        delete costs O(1) extra time on average.  Nodes in the arena
+ *        aren't freed when they're deleted:  the whole arena is freed
+ *        by the next Compact or by Free_list.
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include "oplog.h"
+#ifdef NODE_POOL
+#include "node_pool.h"
+#endif
+
+#define COMPACT_MIN 1024     /* Don't compact shorter lists */
+#define COMPACT_PERCENT 25
 
 struct list_node_s {
    int    data;
    struct list_node_s* next;
 };
 
+/* Array of nodes in key order built by Compact */
+struct arena_s {
+   struct list_node_s* nodes;
+   int    size;        /* Number of nodes in the array */
+   int    live;        /* Number of them that are still in the list */
+};
+struct arena_s arena = {NULL, 0, 0};
+int list_size = 0;
+
+/* Logs for recording and replaying commands (see oplog.c) */
+struct oplog_s* record_log = NULL;
+struct oplog_s* replay_log = NULL;
+
 int  Insert(int value, struct list_node_s** head_p);
 void Print(struct list_node_s* head_p);
 int  Member(int value, struct list_node_s* head_p);
 int  Delete(int value, struct list_node_s** head_p);
 void Free_list(struct list_node_s** head_p);
 int  Is_empty(struct list_node_s* head_p);
+int  Insert_batch(int values[], int n, struct list_node_s** head_pp);
+int  Member_batch(int values[], int n, struct list_node_s* head_p);
+int  Delete_batch(int values[], int n, struct list_node_s** head_pp);
+void Batch(struct list_node_s** head_pp);
+int  Compare(const void* x_p, const void* y_p);
+struct list_node_s* Allocate_node(void);
+int  In_arena(struct list_node_s* node_p);
+int  Fragmented(void);
+void Compact(struct list_node_s** head_pp);
+void Free_node(struct list_node_s* node_p);
+void Usage(char* prog_name);
 char Get_command(void);
 int  Get_value(void);
 
 /*-----------------------------------------------------------------*/
-int main(void) {
+int main(int argc, char* argv[]) {
    char command;
    int  value;
    struct list_node_s* head_p = NULL;  /* start with empty list */
 
+   if (argc == 3 && argv[1][0] == 'r')
+      record_log = Oplog_create(argv[2]);
+   else if (argc == 3 && argv[1][0] == 'p')
+      replay_log = Oplog_open(argv[2]);
+   else if (argc != 1)
+      Usage(argv[0]);
+
+#  ifdef NODE_POOL
+   Pool_init(sizeof(struct list_node_s));
+#  endif
    command = Get_command();
    while (command != 'q' && command != 'Q') {
       switch (command) {
@@ -61,17 +127,50 @@ int main(void) {
             value = Get_value();
             Delete(value, &head_p);  /* Ignore return value */
             break;
+         case 'b':
+         case 'B':
+            Batch(&head_p);
+            break;
+         case 'c':
+         case 'C':
+            Compact(&head_p);
+            printf("Compacted %d nodes\n", arena.size);
+            break;
          default:
             printf("There is no %c command\n", command);
             printf("Please try again\n");
       }
+      if (Fragmented()) {
+#        ifdef DEBUG
+         printf("Compacting %d nodes\n", list_size);
+#        endif
+         Compact(&head_p);
+      }
       command = Get_command();
    }
    Free_list(&head_p);
+#  ifdef NODE_POOL
+   Pool_destroy();
+#  endif
+
+   if (record_log != NULL) Oplog_close(record_log);
+   if (replay_log != NULL) Oplog_close(replay_log);
 
    return 0;
 }  /* main */
 
+/*-----------------------------------------------------------------*/
+/* Function:   Usage
+ * Purpose:    Print a message showing the command line arguments
+ *             and quit
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s [r <file> | p <file>]\n", prog_name);
+   fprintf(stderr, "   r:  record the commands in file\n");
+   fprintf(stderr, "   p:  replay the commands recorded in file\n");
+   exit(0);
+}  /* Usage */
+
 
 /*-----------------------------------------------------------------*/
 /* Function:   Insert
@@ -93,7 +192,7 @@ int Insert(int value, struct list_node_s** head_pp) {
    }
 
    if (curr_p == NULL || curr_p->data > value) {
-      temp_p = malloc(sizeof(struct list_node_s));
+      temp_p = Allocate_node();
       temp_p->data = value;
       temp_p->next = curr_p;
       if (pred_p == NULL)
@@ -173,13 +272,13 @@ int Delete(int value, struct list_node_s** head_pp) {
 #        ifdef DEBUG
          printf("Freeing %d\n", value);
 #        endif
-         free(curr_p);
+         Free_node(curr_p);
       } else { 
          pred_p->next = curr_p->next;
 #        ifdef DEBUG
          printf("Freeing %d\n", value);
 #        endif
-         free(curr_p);
+         Free_node(curr_p);
       }
       return 1;
    } else {
@@ -188,6 +287,260 @@ int Delete(int value, struct list_node_s** head_pp) {
    }
 }  /* Delete */
 
+/*-----------------------------------------------------------------*/
+/* Function:    Insert_batch
+ * Purpose:     Insert the values in values[] into the list in a
+ *              single pass.  Values that are already in the list are
+ *              ignored.
+ * In arg:      n, the number of values
+ * In/out args: values, sorted on return
+ *              head_pp, a pointer to the head of the list pointer
+ * Return val:  The number of values inserted
+ */
+int Insert_batch(int values[], int n, struct list_node_s** head_pp) {
+   struct list_node_s* curr_p = *head_pp;
+   struct list_node_s* pred_p = NULL;
+   struct list_node_s* temp_p;
+   int i, count = 0;
+
+   qsort(values, n, sizeof(int), Compare);
+   for (i = 0; i < n; i++) {
+      if (i > 0 && values[i] == values[i-1]) continue;
+      while (curr_p != NULL && curr_p->data < values[i]) {
+         pred_p = curr_p;
+         curr_p = curr_p->next;
+      }
+      if (curr_p == NULL || curr_p->data > values[i]) {
+         temp_p = Allocate_node();
+         temp_p->data = values[i];
+         temp_p->next = curr_p;
+         if (pred_p == NULL)
+            *head_pp = temp_p;
+         else
+            pred_p->next = temp_p;
+         pred_p = temp_p;
+         count++;
+      }
+   }
+
+   return count;
+}  /* Insert_batch */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Member_batch
+ * Purpose:     Search the list for each of the values in values[]
+ *              in a single pass
+ * In args:     n, the number of values
+ *              head_p, pointer to the head of the list
+ * In/out arg:  values, sorted on return
+ * Return val:  The number of distinct values that are in the list
+ */
+int Member_batch(int values[], int n, struct list_node_s* head_p) {
+   struct list_node_s* curr_p = head_p;
+   int i, count = 0;
+
+   qsort(values, n, sizeof(int), Compare);
+   for (i = 0; i < n; i++) {
+      if (i > 0 && values[i] == values[i-1]) continue;
+      while (curr_p != NULL && curr_p->data < values[i])
+         curr_p = curr_p->next;
+      if (curr_p == NULL) break;
+      if (curr_p->data == values[i]) count++;
+   }
+
+   return count;
+}  /* Member_batch */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Delete_batch
+ * Purpose:     Delete the values in values[] from the list in a
+ *              single pass.  Values that aren't in the list are
+ *              ignored.
+ * In arg:      n, the number of values
+ * In/out args: values, sorted on return
+ *              head_pp, pointer to the head of the list pointer
+ * Return val:  The number of values deleted
+ */
+int Delete_batch(int values[], int n, struct list_node_s** head_pp) {
+   struct list_node_s* curr_p = *head_pp;
+   struct list_node_s* pred_p = NULL;
+   int i, count = 0;
+
+   qsort(values, n, sizeof(int), Compare);
+   for (i = 0; i < n; i++) {
+      while (curr_p != NULL && curr_p->data < values[i]) {
+         pred_p = curr_p;
+         curr_p = curr_p->next;
+      }
+      if (curr_p == NULL) break;
+      if (curr_p->data == values[i]) {
+         if (pred_p == NULL)
+            *head_pp = curr_p->next;
+         else
+            pred_p->next = curr_p->next;
+#        ifdef DEBUG
+         printf("Freeing %d\n", values[i]);
+#        endif
+         Free_node(curr_p);
+         curr_p = (pred_p == NULL) ? *head_pp : pred_p->next;
+         count++;
+      }
+   }
+
+   return count;
+}  /* Delete_batch */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Batch
+ * Purpose:     Read an op, the number of values, and the values from
+ *              stdin, and carry out the op on all the values in a
+ *              single pass over the list
+ * In/out arg:  head_pp, pointer to the head of the list pointer
+ */
+void Batch(struct list_node_s** head_pp) {
+   char op;
+   int  i, n, count;
+   int* values;
+
+   op = Get_command();
+   if (replay_log != NULL) {
+      n = Oplog_get_int(replay_log);
+   } else {
+      printf("How many values?  ");
+      scanf("%d", &n);
+      if (record_log != NULL) Oplog_put_int(record_log, n);
+   }
+   if (n <= 0) return;
+   values = malloc(n*sizeof(int));
+   for (i = 0; i < n; i++)
+      values[i] = Get_value();
+
+   switch (op) {
+      case 'i':
+      case 'I':
+         count = Insert_batch(values, n, head_pp);
+         printf("Inserted %d of %d values\n", count, n);
+         break;
+      case 'm':
+      case 'M':
+         count = Member_batch(values, n, *head_pp);
+         printf("%d of %d values are in the list\n", count, n);
+         break;
+      case 'd':
+      case 'D':
+         count = Delete_batch(values, n, head_pp);
+         printf("Deleted %d of %d values\n", count, n);
+         break;
+      default:
+         printf("There is no batch %c command\n", op);
+   }
+   free(values);
+}  /* Batch */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Compare
+ * Purpose:     Compare two ints, for use by qsort
+ * In args:     x_p, y_p
+ * Return val:  -1 if *x_p < *y_p, 0 if *x_p == *y_p, 1 otherwise
+ */
+int Compare(const void* x_p, const void* y_p) {
+   int x = *((int*)x_p);
+   int y = *((int*)y_p);
+
+   if (x < y)
+      return -1;
+   else if (x == y)
+      return 0;
+   else /* x > y */
+      return 1;
+}  /* Compare */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Allocate_node
+ * Purpose:    Get storage for a list node from the node pool, if the
+ *             program was compiled with -DNODE_POOL, or from malloc
+ * Return val: Pointer to the uninitialized node
+ */
+struct list_node_s* Allocate_node(void) {
+   list_size++;
+#  ifdef NODE_POOL
+   return Pool_alloc();
+#  else
+   return malloc(sizeof(struct list_node_s));
+#  endif
+}  /* Allocate_node */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Free_node
+ * Purpose:    Return the storage used by a list node to the node pool
+ *             or free it.  Nodes in the arena are just counted.
+ * In arg:     node_p, pointer to the node
+ */
+void Free_node(struct list_node_s* node_p) {
+   list_size--;
+   if (In_arena(node_p)) {
+      arena.live--;
+      return;
+   }
+#  ifdef NODE_POOL
+   Pool_free(node_p);
+#  else
+   free(node_p);
+#  endif
+}  /* Free_node */
+
+/*-----------------------------------------------------------------*/
+/* Function:   In_arena
+ * Purpose:    Determine whether a node is in the arena
+ * Return val: 1 if it is, 0 if it was allocated by Allocate_node
+ */
+int In_arena(struct list_node_s* node_p) {
+   return node_p >= arena.nodes && node_p < arena.nodes + arena.size;
+}  /* In_arena */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Fragmented
+ * Purpose:    Decide whether the list should be compacted
+ * Return val: 1 if the nodes outside the arena plus the holes in the
+ *             arena are more than COMPACT_PERCENT percent of the list,
+ *             0 otherwise
+ */
+int Fragmented(void) {
+   long out_of_place = (list_size - arena.live) + (arena.size - arena.live);
+
+   if (list_size < COMPACT_MIN) return 0;
+   return 100*out_of_place > (long) COMPACT_PERCENT*list_size;
+}  /* Fragmented */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Compact
+ * Purpose:    Copy the nodes into a new arena in key order, free the
+ *             old nodes and the old arena
+ * In/out arg: head_pp, pointer to the head of the list pointer
+ */
+void Compact(struct list_node_s** head_pp) {
+   struct list_node_s* nodes;
+   struct list_node_s* curr_p = *head_pp;
+   struct list_node_s* succ_p;
+   int i = 0;
+
+   nodes = (list_size > 0) ?
+      malloc(list_size*sizeof(struct list_node_s)) : NULL;
+   while (curr_p != NULL) {
+      succ_p = curr_p->next;
+      nodes[i].data = curr_p->data;
+      nodes[i].next = (succ_p != NULL) ? &nodes[i+1] : NULL;
+      Free_node(curr_p);
+      curr_p = succ_p;
+      i++;
+   }
+   free(arena.nodes);
+
+   arena.nodes = nodes;
+   arena.size = arena.live = list_size = i;
+   *head_pp = nodes;
+}  /* Compact */
+
 /*-----------------------------------------------------------------*/
 /* Function:   Free_list
  * Purpose:    Free the storage used by the list
@@ -205,15 +558,18 @@ void Free_list(struct list_node_s** head_pp) {
 #     ifdef DEBUG
       printf("Freeing %d\n", curr_p->data);
 #     endif
-      free(curr_p);
+      Free_node(curr_p);
       curr_p = succ_p;
       succ_p = curr_p->next;
    }
 #  ifdef DEBUG
    printf("Freeing %d\n", curr_p->data);
 #  endif
-   free(curr_p);
+   Free_node(curr_p);
    *head_pp = NULL;
+   free(arena.nodes);
+   arena.nodes = NULL;
+   arena.size = arena.live = 0;
 }  /* Free_list */
 
 /*-----------------------------------------------------------------*/
@@ -237,9 +593,11 @@ int  Is_empty(struct list_node_s* head_p) {
 char Get_command(void) {
    char c;
 
+   if (replay_log != NULL) return Oplog_get_op(replay_log);
    printf("Please enter a command:  ");
    /* Put the space before the %c so scanf will skip white space */
-   scanf(" %c", &c);
+   if (scanf(" %c", &c) != 1) c = 'q';  /* End of input */
+   if (record_log != NULL) Oplog_put_op(record_log, c);
    return c;
 }  /* Get_command */
 
@@ -251,7 +609,9 @@ char Get_command(void) {
 int  Get_value(void) {
    int val;
 
+   if (replay_log != NULL) return Oplog_get_int(replay_log);
    printf("Please enter a value:  ");
    scanf("%d", &val);
+   if (record_log != NULL) Oplog_put_int(record_log, val);
    return val;
 }  /* Get_value */
\ No newline at end of file
@@ -7,8 +7,8 @@
  *           followed by arguments needed by operators.
  * Output:   Results of operations.
  *
- * Compile:  gcc -g -Wall -o linked_list linked_list.c
- * Run:      ./linked_list
+ * Compile:  gcc -g -Wall -o linked_list1 linked_list1.c oplog.c
+ * Run:      ./linked_list1 [r <file> | p <file>]
  *
  * Notes:
  *    1.  Repeated values are allowed in the list
@@ -16,30 +16,50 @@
  *    3.  Program assumes an int will be entered when prompted
  *        for one.
  *    4.  This program has  a serious bug . . .
+ *    5.  With r <file>, the commands and their arguments are recorded
+ *        in file as they're read.  With p <file>, they're replayed from
+ *        file instead of being read from stdin, and the prompts aren't
+ *        printed.  The file is a compact binary log (see oplog.c), so
+ *        a long trace can be replayed much faster than it can be
+ *        read with scanf.
+ *    6.  At the end of stdin, the program acts as if q was entered.
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include "oplog.h"
 
 struct list_node_s {
    int    data;
    struct list_node_s* next_p;
 };
 
+/* Logs for recording and replaying commands (see oplog.c) */
+struct oplog_s* record_log = NULL;
+struct oplog_s* replay_log = NULL;
+
 int  Member(struct list_node_s* head_p, int val);
 struct list_node_s* Insert(struct list_node_s* head_p, int val);
 struct list_node_s* Delete(struct list_node_s* head_p, int val);
 void Print(struct list_node_s* head_p);
 struct list_node_s* Free_list(struct list_node_s* head_p); 
+void Usage(char* prog_name);
 char Get_command(void);
 int  Get_value(void);
 
 /*-----------------------------------------------------------------*/
-int main(void) {
+int main(int argc, char* argv[]) {
    char command;
    int  value;
    struct list_node_s* head_p = NULL;  
       /* start with empty list */
 
+   if (argc == 3 && argv[1][0] == 'r')
+      record_log = Oplog_create(argv[2]);
+   else if (argc == 3 && argv[1][0] == 'p')
+      replay_log = Oplog_open(argv[2]);
+   else if (argc != 1)
+      Usage(argv[0]);
+
    command = Get_command();
    while (command != 'q' && command != 'Q') {
       switch (command) {
@@ -78,9 +98,24 @@ int main(void) {
 
    head_p = Free_list(head_p);
 
+   if (record_log != NULL) Oplog_close(record_log);
+   if (replay_log != NULL) Oplog_close(replay_log);
+
    return 0;
 }  /* main */
 
+/*-----------------------------------------------------------------*/
+/* Function:   Usage
+ * Purpose:    Print a message showing the command line arguments
+ *             and quit
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s [r <file> | p <file>]\n", prog_name);
+   fprintf(stderr, "   r:  record the commands in file\n");
+   fprintf(stderr, "   p:  replay the commands recorded in file\n");
+   exit(0);
+}  /* Usage */
+
 
 /*-----------------------------------------------------------------
  * Function:    Member
@@ -196,9 +231,11 @@ struct list_node_s* Free_list(struct list_node_s* head_p) {
 char Get_command(void) {
    char c;
 
+   if (replay_log != NULL) return Oplog_get_op(replay_log);
    printf("Please enter a command (i, p, m, d, f, q):  ");
    /* Put the space before the %c so scanf will skip white space */
-   scanf(" %c", &c);
+   if (scanf(" %c", &c) != 1) c = 'q';  /* End of input */
+   if (record_log != NULL) Oplog_put_op(record_log, c);
    return c;
 }  /* Get_command */
 
@@ -211,7 +248,9 @@ char Get_command(void) {
 int  Get_value(void) {
    int val;
 
+   if (replay_log != NULL) return Oplog_get_int(replay_log);
    printf("Please enter a value:  ");
    scanf("%d", &val);
+   if (record_log != NULL) Oplog_put_int(record_log, val);
    return val;
 }  /* Get_value */
\ No newline at end of file
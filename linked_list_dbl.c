@@ -10,52 +10,142 @@
  *           double or single quotes.
  * Output:   Results of operations.
  *
- * Compile:  gcc -g -Wall -o linked_list_dbl linked_list_dbl.c
- *           (See note 2.)
+ * Compile:  gcc -g -Wall -o linked_list_dbl linked_list_dbl.c oplog.c
+ *           (See notes 2 and 8.)
  *
- * Run:      ./linked_list_dbl
+ * Run:      ./linked_list_dbl [r <file> | p <file>]
  *
  * Notes:
  *    1.  Repeated strings are *not* allowed in the list
  *    2.  DEBUG compile flag used.  To get debug output compile with
  *        -DDEBUG command line flag.
+ *    3.  With r <file>, the commands and their arguments are recorded
+ *        in file as they're read.  With p <file>, they're replayed from
+ *        file instead of being read from stdin, and the prompts aren't
+ *        printed.  The file is a compact binary log (see oplog.c), so
+ *        a long trace can be replayed much faster than it can be
+ *        read with scanf.
+ *    4.  At the end of stdin, the program acts as if q was entered.
+ *    5.  A node and its string are allocated together:  the string
+ *        is stored in the node, after the pointers.  Nodes are carved
+ *        out of ARENA_CHUNK byte chunks, and a deleted node is put on
+ *        a free list for nodes of its size, rounded up to a multiple
+ *        of ALIGN bytes, so there's no call to malloc or free for most
+ *        inserts and deletes.  The chunks are freed by Free_arena.
+ *    6.  Each node also stores the first 8 chars of its string as a
+ *        big-endian 64-bit int, padded with zeroes (the prefix).  So
+ *        comparing the prefixes of two strings gives the same order as
+ *        strcmp, unless they're equal, and strcmp is only called when
+ *        two strings have the same first 8 chars.
+ *    7.  A search for a string starts at the head or the tail of the
+ *        list, whichever is closer.  The distance is estimated by
+ *        interpolating the string's prefix between the prefixes of the
+ *        first and last nodes, so it works best when the strings are
+ *        spread fairly evenly.
+ *    8.  HASH_INDEX compile flag used.  If it's defined, the list also
+ *        keeps an open-addressing hash table of pointers to its nodes,
+ *        so Member and Delete find a string without searching the
+ *        list, and Insert only searches the list for the position of a
+ *        string that isn't already there.  Deleted slots are marked
+ *        with TOMBSTONE, and the table is rebuilt when more than 3/4
+ *        of its slots are in use.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include "oplog.h"
 
 const int STRING_MAX = 100;
 
+#define ARENA_CHUNK 65536    /* Bytes in each chunk of the arena */
+#define ALIGN 16             /* Node sizes are multiples of ALIGN */
+#define SIZE_CLASSES 16      /* Larger nodes are malloced */
+
 struct list_node_s {
-   char*  data;
+   uint64_t prefix;
    struct list_node_s* prev_p;
    struct list_node_s* next_p;
+   char   data[];
+};
+
+/* Storage for the nodes */
+struct arena_s {
+   char*  chunk;             /* Current chunk */
+   int    used;              /* Bytes used in current chunk */
+   struct list_node_s* free_p[SIZE_CLASSES];
 };
+struct arena_s arena = {NULL, ARENA_CHUNK, {NULL}};
 
 struct list_s {
    struct list_node_s* h_p;
    struct list_node_s* t_p;
+#  ifdef HASH_INDEX
+   struct list_node_s** slots;  /* Hash table of the nodes */
+   unsigned long mask;          /* Number of slots - 1 */
+   unsigned long count;         /* Nodes in the table */
+   unsigned long used;          /* Nodes + tombstones */
+#  endif
 };
 
+#ifdef HASH_INDEX
+#define INDEX_MIN 64         /* Initial number of slots */
+
+/* Marks a slot whose node was deleted */
+struct list_node_s tombstone;
+#define TOMBSTONE (&tombstone)
+#endif
+
+/* Logs for recording and replaying commands (see oplog.c) */
+struct oplog_s* record_log = NULL;
+struct oplog_s* replay_log = NULL;
+
 void Insert(struct list_s* list_p, char string[]);
 void Print(struct list_s* list_p);
 int  Member(struct list_s* list_p, char string[]);
 void Delete(struct list_s* list_p, char string[]);
 void Free_list(struct list_s* list_p);
+void Usage(char* prog_name);
 char Get_command(void);
 void Get_string(char string[]);
 void Free_node(struct list_node_s* node_p);
+void Free_arena(void);
+int  Size_class(int size);
+uint64_t Prefix(char string[]);
+int  Compare(uint64_t prefix, char string[], struct list_node_s* node_p);
+struct list_node_s* Find(struct list_s* list_p, char string[],
+      uint64_t prefix, int* found_p);
+int  Closer_to_head(struct list_s* list_p, uint64_t prefix);
+#ifdef HASH_INDEX
+void Index_init(struct list_s* list_p, unsigned long size);
+struct list_node_s* Index_find(struct list_s* list_p, char string[],
+      uint64_t prefix);
+void Index_add(struct list_s* list_p, struct list_node_s* node_p);
+void Index_remove(struct list_s* list_p, struct list_node_s* node_p);
+void Index_grow(struct list_s* list_p);
+unsigned long Hash(char string[]);
+#endif
 struct list_node_s* Allocate_node(int size);
 void Print_node(char title[], struct list_node_s* node_p);
 
 /*-----------------------------------------------------------------*/
-int main(void) {
+int main(int argc, char* argv[]) {
    char        command;
    char        string[STRING_MAX];
    struct list_s list ;  
 
+   if (argc == 3 && argv[1][0] == 'r')
+      record_log = Oplog_create(argv[2]);
+   else if (argc == 3 && argv[1][0] == 'p')
+      replay_log = Oplog_open(argv[2]);
+   else if (argc != 1)
+      Usage(argv[0]);
+
    list.h_p = list.t_p = NULL;
       /* start with empty list */
+#  ifdef HASH_INDEX
+   Index_init(&list, INDEX_MIN);
+#  endif
 
    command = Get_command();
    while (command != 'q' && command != 'Q') {
@@ -93,23 +183,61 @@ int main(void) {
       command = Get_command();
    }
    Free_list(&list);
+   Free_arena();
+#  ifdef HASH_INDEX
+   free(list.slots);
+#  endif
+
+   if (record_log != NULL) Oplog_close(record_log);
+   if (replay_log != NULL) Oplog_close(replay_log);
 
    return 0;
 }  /* main */
 
+/*-----------------------------------------------------------------*/
+/* Function:   Usage
+ * Purpose:    Print a message showing the command line arguments
+ *             and quit
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s [r <file> | p <file>]\n", prog_name);
+   fprintf(stderr, "   r:  record the commands in file\n");
+   fprintf(stderr, "   p:  replay the commands recorded in file\n");
+   exit(0);
+}  /* Usage */
+
 
 /*-----------------------------------------------------------------*/
 /* Function:   Allocate_node
- * Purpose:    Allocate storage for a list node
+ * Purpose:    Allocate storage for a list node and its string
  * Input arg:  size = number of chars needed in data member (including
  *                storage for the terminating null)
  * Return val: Pointer to the new node
+ * Note:       The node is taken from the free list for its size, or
+ *             from the current chunk of the arena.  When the chunk is
+ *             used up a new one is allocated.  The first ALIGN bytes
+ *             of a chunk point to the previous chunk.
  */
 struct list_node_s* Allocate_node(int size) {
    struct list_node_s* temp_p;
-
-   temp_p = malloc(sizeof(struct list_node_s));
-   temp_p->data = malloc(size*sizeof(char));
+   int c = Size_class(size);
+   char* chunk;
+
+   if (c >= SIZE_CLASSES) {
+      temp_p = malloc(sizeof(struct list_node_s) + size);
+   } else if (arena.free_p[c] != NULL) {
+      temp_p = arena.free_p[c];
+      arena.free_p[c] = temp_p->next_p;
+   } else {
+      if (arena.used + c*ALIGN > ARENA_CHUNK) {
+         chunk = aligned_alloc(ALIGN, ARENA_CHUNK);
+         *((char**) chunk) = arena.chunk;
+         arena.chunk = chunk;
+         arena.used = ALIGN;
+      }
+      temp_p = (struct list_node_s*) (arena.chunk + arena.used);
+      arena.used += c*ALIGN;
+   }
    temp_p->prev_p = NULL;
    temp_p->next_p = NULL;
    return temp_p;
@@ -125,22 +253,27 @@ struct list_node_s* Allocate_node(int size) {
  *                and return, leaving list unchanged
  */
 void Insert(struct list_s* list_p, char string[]) {
-   struct list_node_s* curr_p = list_p->h_p;
+   struct list_node_s* curr_p;
    struct list_node_s* temp_p;
+   uint64_t prefix = Prefix(string);
+   int found;
 
 #  ifdef DEBUG
-   printf("In Insert, string = %s\n");
+   printf("In Insert, string = %s\n", string);
 #  endif
 
-   while (curr_p != NULL)
-      if (strcmp(string, curr_p->data) == 0) {
-         printf("%s is already in the list\n", string);
-         return;  
-      } else if (strcmp(string, curr_p->data) < 0) {
-         break;  /* string alphabetically precedes node */
-      } else {
-         curr_p = curr_p->next_p;
-      }
+#  ifdef HASH_INDEX
+   if (Index_find(list_p, string, prefix) != NULL) {
+      printf("%s is already in the list\n", string);
+      return;
+   }
+#  endif
+   curr_p = Find(list_p, string, prefix, &found);
+   if (found) {
+      printf("%s is already in the list\n", string);
+      return;  
+   }
+   /* string alphabetically precedes curr_p */
 
 #  ifdef DEBUG
    Print_node("Exited Insert loop: curr_p", curr_p);
@@ -148,6 +281,7 @@ void Insert(struct list_s* list_p, char string[]) {
 
    temp_p = Allocate_node(strlen(string) + 1);
    strcpy(temp_p->data, string);
+   temp_p->prefix = prefix;
 
    if ( list_p->h_p == NULL ) {
       /* list is empty */
@@ -169,6 +303,9 @@ void Insert(struct list_s* list_p, char string[]) {
       curr_p->prev_p = temp_p;
       temp_p->prev_p->next_p = temp_p;
    }
+#  ifdef HASH_INDEX
+   Index_add(list_p, temp_p);
+#  endif
 }  /* Insert */
 
 /*-----------------------------------------------------------------*/
@@ -197,29 +334,254 @@ void Print(struct list_s* list_p) {
  * Return val: 1, if string is in the list, 0 otherwise
  */
 int  Member(struct list_s* list_p, char string[]) {
-   struct list_node_s* curr_p;
+   uint64_t prefix = Prefix(string);
+   int found;
 
-   curr_p = list_p->h_p;
-   while (curr_p != NULL) 
-      if (strcmp(string, curr_p->data) == 0)
-         return 1;
-      else if (strcmp(string, curr_p->data) < 0)
-         return 0;
-      else
-         curr_p = curr_p->next_p;
-   return 0;
+#  ifdef HASH_INDEX
+   found = (Index_find(list_p, string, prefix) != NULL);
+#  else
+   Find(list_p, string, prefix, &found);
+#  endif
+   return found;
 }  /* Member */
 
 /*-----------------------------------------------------------------*/
 /* Function:   Free_node
- * Purpose:    Free storage used by a node of the list
+ * Purpose:    Put a node on the free list for its size, or free it if
+ *             it was malloced
  * In/out arg: node_p = pointer to node to be freed
  */
 void Free_node(struct list_node_s* node_p) {
-   free(node_p->data);
-   free(node_p);
+   int c = Size_class(strlen(node_p->data) + 1);
+
+   if (c >= SIZE_CLASSES) {
+      free(node_p);
+   } else {
+      node_p->next_p = arena.free_p[c];
+      arena.free_p[c] = node_p;
+   }
 }  /* Free_node */
 
+/*-----------------------------------------------------------------*/
+/* Function:   Free_arena
+ * Purpose:    Free all the chunks of the arena.  Any nodes that are
+ *             still in a list can't be used after this.
+ */
+void Free_arena(void) {
+   char* chunk;
+   int c;
+
+   while (arena.chunk != NULL) {
+      chunk = arena.chunk;
+      arena.chunk = *((char**) chunk);
+      free(chunk);
+   }
+   arena.used = ARENA_CHUNK;
+   for (c = 0; c < SIZE_CLASSES; c++)
+      arena.free_p[c] = NULL;
+}  /* Free_arena */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Size_class
+ * Purpose:    Find the number of ALIGN byte units needed by a node
+ *             whose string takes size chars (including the null)
+ */
+int Size_class(int size) {
+   return (sizeof(struct list_node_s) + size + ALIGN - 1)/ALIGN;
+}  /* Size_class */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Prefix
+ * Purpose:    Pack the first 8 chars of string into a 64-bit int, with
+ *             the first char in the most significant byte.  If the
+ *             string is shorter, the remaining bytes are 0.
+ */
+uint64_t Prefix(char string[]) {
+   uint64_t prefix = 0;
+   int i;
+
+   for (i = 0; i < 8 && string[i] != '\0'; i++)
+      prefix |= (uint64_t) (unsigned char) string[i] << (56 - 8*i);
+   return prefix;
+}  /* Prefix */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Compare
+ * Purpose:    Compare string, whose prefix is prefix, to the string
+ *             in a node
+ * Return val: < 0, 0, or > 0, like strcmp(string, node_p->data)
+ * Note:       If the prefixes are equal and the last byte is 0, both
+ *             strings have fewer than 8 chars, and they're equal.
+ */
+int Compare(uint64_t prefix, char string[], struct list_node_s* node_p) {
+   if (prefix < node_p->prefix)
+      return -1;
+   else if (prefix > node_p->prefix)
+      return 1;
+   else if ((prefix & 0xff) == 0)
+      return 0;
+   else
+      return strcmp(string + 8, node_p->data + 8);
+}  /* Compare */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Find
+ * Purpose:    Search the list for string, starting from the head or
+ *             the tail, whichever seems closer (see note 7)
+ * Input args: string = string to search for
+ *             prefix = Prefix(string)
+ * Out arg:    found_p = 1 if string is in the list, 0 otherwise
+ * Return val: The node containing string if it's in the list.
+ *             Otherwise the first node whose string follows string,
+ *             or NULL if there isn't one.
+ */
+struct list_node_s* Find(struct list_s* list_p, char string[],
+      uint64_t prefix, int* found_p) {
+   struct list_node_s* curr_p;
+   int order = 1;
+
+   if (Closer_to_head(list_p, prefix)) {
+      curr_p = list_p->h_p;
+      while (curr_p != NULL) {
+         order = Compare(prefix, string, curr_p);
+         if (order <= 0) break;
+         curr_p = curr_p->next_p;
+      }
+      *found_p = (order == 0);
+      return curr_p;
+   } else {
+      curr_p = list_p->t_p;
+      while (curr_p != NULL) {
+         order = Compare(prefix, string, curr_p);
+         if (order >= 0) break;
+         curr_p = curr_p->prev_p;
+      }
+      *found_p = (order == 0);
+      if (order == 0)
+         return curr_p;
+      else if (curr_p == NULL)
+         return list_p->h_p;
+      else
+         return curr_p->next_p;
+   }
+}  /* Find */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Closer_to_head
+ * Purpose:    Estimate whether a string with this prefix is closer to
+ *             the head of the list than to the tail
+ * Return val: 1 if it is, or if the list is empty, 0 otherwise
+ */
+int Closer_to_head(struct list_s* list_p, uint64_t prefix) {
+   uint64_t h, t;
+
+   if (list_p->h_p == NULL) return 1;
+   h = list_p->h_p->prefix;
+   t = list_p->t_p->prefix;
+   if (prefix <= h) return 1;
+   if (prefix >= t) return 0;
+   return prefix - h <= t - prefix;
+}  /* Closer_to_head */
+
+#ifdef HASH_INDEX
+/*-----------------------------------------------------------------*/
+/* Function:   Index_init
+ * Purpose:    Allocate an empty hash table with size slots
+ * Note:       size must be a power of 2
+ */
+void Index_init(struct list_s* list_p, unsigned long size) {
+   list_p->slots = calloc(size, sizeof(struct list_node_s*));
+   if (list_p->slots == NULL) {
+      fprintf(stderr, "Index_init:  can't allocate %lu slots\n", size);
+      exit(-1);
+   }
+   list_p->mask = size - 1;
+   list_p->count = list_p->used = 0;
+}  /* Index_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Index_find
+ * Purpose:    Look up string in the hash table
+ * Return val: The node containing string, or NULL if it isn't in
+ *             the list
+ */
+struct list_node_s* Index_find(struct list_s* list_p, char string[],
+      uint64_t prefix) {
+   unsigned long i = Hash(string) & list_p->mask;
+   struct list_node_s* node_p;
+
+   while ((node_p = list_p->slots[i]) != NULL) {
+      if (node_p != TOMBSTONE && Compare(prefix, string, node_p) == 0)
+         return node_p;
+      i = (i + 1) & list_p->mask;
+   }
+   return NULL;
+}  /* Index_find */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Index_add
+ * Purpose:    Add a node whose string isn't in the table
+ */
+void Index_add(struct list_s* list_p, struct list_node_s* node_p) {
+   unsigned long i;
+
+   if (4*(list_p->used + 1) > 3*(list_p->mask + 1))
+      Index_grow(list_p);
+   i = Hash(node_p->data) & list_p->mask;
+   while (list_p->slots[i] != NULL && list_p->slots[i] != TOMBSTONE)
+      i = (i + 1) & list_p->mask;
+   if (list_p->slots[i] == NULL) list_p->used++;
+   list_p->slots[i] = node_p;
+   list_p->count++;
+}  /* Index_add */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Index_remove
+ * Purpose:    Replace the table's pointer to node_p with a tombstone
+ */
+void Index_remove(struct list_s* list_p, struct list_node_s* node_p) {
+   unsigned long i = Hash(node_p->data) & list_p->mask;
+
+   while (list_p->slots[i] != node_p)
+      i = (i + 1) & list_p->mask;
+   list_p->slots[i] = TOMBSTONE;
+   list_p->count--;
+}  /* Index_remove */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Index_grow
+ * Purpose:    Rebuild the table without tombstones, doubling its size
+ *             if more than half the slots hold nodes
+ */
+void Index_grow(struct list_s* list_p) {
+   struct list_node_s** old = list_p->slots;
+   unsigned long old_size = list_p->mask + 1;
+   unsigned long size = old_size;
+   unsigned long i;
+
+   if (2*list_p->count >= old_size) size *= 2;
+   Index_init(list_p, size);
+   for (i = 0; i < old_size; i++)
+      if (old[i] != NULL && old[i] != TOMBSTONE)
+         Index_add(list_p, old[i]);
+   free(old);
+}  /* Index_grow */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Hash
+ * Purpose:    Hash a string (64-bit FNV-1a)
+ */
+unsigned long Hash(char string[]) {
+   uint64_t h = 0xcbf29ce484222325ULL;
+
+   while (*string != '\0') {
+      h ^= (unsigned char) *string++;
+      h *= 0x100000001b3ULL;
+   }
+   return h ^ (h >> 32);
+}  /* Hash */
+#endif
+
 /*-----------------------------------------------------------------*/
 /* Function:   Delete
  * Purpose:    Delete node containing string.
@@ -231,18 +593,19 @@ void Free_node(struct list_node_s* node_p) {
  *             returns, leaving the list unchanged.
  */
 void Delete(struct list_s* list_p, char string[]) {
-   struct list_node_s* curr_p = list_p->h_p;
+   struct list_node_s* curr_p;
+   uint64_t prefix = Prefix(string);
+#  ifndef HASH_INDEX
+   int found;
+#  endif
 
    /* Find string */
-   while (curr_p != NULL) 
-      if (strcmp(string, curr_p->data) == 0) {
-         break;
-      } else if (strcmp(string, curr_p->data) < 0) {
-         printf("%s is not in the list\n", string);
-         return;
-      } else {
-         curr_p = curr_p->next_p;
-      }
+#  ifdef HASH_INDEX
+   curr_p = Index_find(list_p, string, prefix);
+#  else
+   curr_p = Find(list_p, string, prefix, &found);
+   if (!found) curr_p = NULL;
+#  endif
    
    if (curr_p == NULL) {
       printf("%s is not in the list\n", string);
@@ -263,6 +626,9 @@ void Delete(struct list_s* list_p, char string[]) {
          curr_p->prev_p->next_p = curr_p->next_p;
          curr_p->next_p->prev_p = curr_p->prev_p;
       }
+#     ifdef HASH_INDEX
+      Index_remove(list_p, curr_p);
+#     endif
       Free_node(curr_p);
    }
 }  /* Delete */
@@ -287,6 +653,10 @@ void Free_list(struct list_s* list_p) {
    }
 
    list_p->h_p = list_p->t_p = NULL;
+#  ifdef HASH_INDEX
+   free(list_p->slots);
+   Index_init(list_p, INDEX_MIN);
+#  endif
 }  /* Free_list */
 
 
@@ -299,9 +669,11 @@ void Free_list(struct list_s* list_p) {
 char Get_command(void) {
    char c;
 
+   if (replay_log != NULL) return Oplog_get_op(replay_log);
    printf("Please enter a command (i, d, m, p, f, q):  ");
    /* Put the space before the %c so scanf will skip white space */
-   scanf(" %c", &c);
+   if (scanf(" %c", &c) != 1) c = 'q';  /* End of input */
+   if (record_log != NULL) Oplog_put_op(record_log, c);
    return c;
 }  /* Get_command */
 
@@ -312,8 +684,13 @@ char Get_command(void) {
  */
 void Get_string(char string[]) {
 
+   if (replay_log != NULL) {
+      Oplog_get_string(replay_log, string, STRING_MAX);
+      return;
+   }
    printf("Please enter a string:  ");
    scanf("%s", string);
+   if (record_log != NULL) Oplog_put_string(record_log, string);
 }  /* Get_string */
 
 
@@ -1,281 +1,405 @@
- 
- // * Compile:  gcc -g -Wall -o ll linkedlist.c -lm
- // * Run:      ./ll
-/*Write a program that implements merge sort on a linked list of strings.  
-Input will be a list of strings.  You should build a linked list from the input list, 
-print the input list, sort it using one of the two algorithms, 
-and print the result and the time required for the sort.  The input list will come from stdin.  
-The command line may include an "n" that will suppress output of the lists and just print the elapsed time for the sort.
-
-The merge sort algorithm is a little different from the standard algorithm.  
-Instead of recursively splitting the list in half,  you double the list size with each pass:
-
-      for (list_size = 2; list_size <= n; list_size *= 2) {
-            Sort(elements list_size/2, ..., list_size);
-            Merge sublist 0,...,list_size/2-1 and sublist list_size/2, ... , list_size);
-      }
-You can initially assume that the list size is a power of two, 
-but in order to get full credit, you need to correctly sort a list of any positive integer size.
-*/
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include "timer.h"
-
-const int max = 100;
-
-struct node {
-   char  *string;
-   struct node* next_p;
-};
-
-struct list_s {
-   struct node* head;
-   struct node* tail;
-};
-void Print2(struct list_s* list_p, int size);
-struct list_s* Merge(struct list_s *list_p, struct list_s* new_list, int size);
-struct list_s* Sort(struct list_s* list_p, int size) ;
-struct node* RightSide(struct list_s* list_p, int size);
-void Delete(struct node* node, struct list_s* list_p, int size);
-void Insert(struct list_s* list_p, char string[]);
-void GetString(char string[]);
-void Print(struct list_s* list_p);
-void Free(struct list_s* list_p);
-
-/*-----------------------------------------------------------------*/
-int main(void) {
-	char string[max];
-	struct list_s* list = malloc(sizeof(struct list_s));
-
-
-	list -> head = list -> tail = NULL; //empty list
-
-	double start = 0;
-	double finish = 0;
-
-	printf("Enter a size for the list\n");  //get the size of the list
-	int size;
-	scanf("%d", &size);
-
-	for(int i = 0; i < size; i ++){
-		GetString(string);
-		Insert(list, string);
-	}
-
-	printf("This is the unsorted list.\n");
-	Print(list);  //prints unsorted input list
-
-	GET_TIME(start);  //starts the wall clock time
-
-	list = Sort(list, size);  //sorts the input list 
-
-	GET_TIME(finish);  //stops the wall clock time
-
-	printf("This is the sorted list.\n");
-	Print(list);  //prints the sorted list after merge
-
-	Free(list);
-	   
-	printf("Elapsed time = %e seconds\n ", finish-start);
-
-	return 0;
-}  /* main */
-
-
-//I'm attaching a short program that implements the merge sort using arrays. 
-// The linked list version is basically the same, except that you don't
-// need any scratch storage (except a couple of pointers):  
-//when you merge, you can insert each new element into the new 
-//list and delete it from the old list.
-/*-----------------------------------------------------------------*/
-/* Function:   Merge
- * Purpose:    Combine two halves of a sorted list
- */
-struct list_s* Merge(struct list_s* left, struct list_s* right, int size) {
-	struct node* current = left -> head;
-	struct node* temp = right -> head;
-
-	struct list_s* tempList = malloc(sizeof(struct list_s));
-	int i ;
-	int l = 0;
-	int r = 0;
-
-	for(i = 0; i < size ; i ++){
-		if(l == size/2 && temp == NULL){
-			return tempList;
-		}
-		else if(current == NULL || l == size/2){ //check to see if any of the lists are done
-			Insert(tempList, temp -> string);
-			temp = temp -> next_p;
-			r++;
-		}
-		else if(temp == NULL || r == size/2){
-			Insert(tempList, current -> string);
-			current = current -> next_p;
-			l++;
-		}
-		else if (strcmp(current -> string, temp -> string) == 0){
-			//same string
-			Insert(tempList, current -> string);
-			Insert(tempList, temp -> string);
-			current = current -> next_p;
-			temp = temp -> next_p;
-			l++;
-			r++;
-		}
-		else if (strcmp(current -> string, temp -> string) < 0){
-			//current is first
-			Insert(tempList, current -> string);
-			current = current -> next_p;
-			l++;
-		}
-		else{
-			//temp is first
-			Insert(tempList, temp -> string);
-			temp = temp -> next_p;
-			r++;
-		}
-	}
-	return tempList;
-
-}  /* Merge */
-
-
-/*------------------------------------------------------------------
- * Function:     Sort
- * Purpose:      Read the first 2 elems sort those, call Merge on 
- *				 4 elems while the 2nd and 3rd items are being sorted 
- * 				 recursively and so on...
- * Input args:   size = size of the array
- *				 list = original list
- * Return val:   void--none
- */
-struct list_s* Sort(struct list_s* list_p, int size) {
-	int list_size;
-	int s = size / 2;
-	int power = 1;
-	for(int j = 0;j<s;j++){
-		power *=2;
-	}
-	struct list_s* right = malloc(sizeof(struct list_s));
-	struct list_s* left = malloc(sizeof(struct list_s));
-	left->head = list_p->head;
-
-	for(list_size = 2; list_size <= power; list_size *= 2){
-		right -> head = RightSide(list_p, list_size);
-		if(right->head ==NULL)
-			return left;
-		right = Sort(right, list_size/2);
-		left = Merge(left, right, list_size);
-	}
-	return left;
-} /*  Sort  */
-
-/*------------------------------------------------------------------
- * Function:     RightSide
- * Purpose:      Get the right half of the array
- * Input args:   size = size of the array
- *				 list = list being sorted
- * Return:	 	 Pointer to the beginning of the right half of the list
- */
-struct node* RightSide(struct list_s* list_p, int size) { 
-	struct node* temp = list_p -> head;
-	int right;
-	for(right = 0; right < size / 2; right ++){
-		temp = temp -> next_p;
-	}
-	return temp;
-} /*  RightSide  */
-
-
-/*-----------------------------------------------------------------*/
-/* Function:   Insert
- * Purpose:    Insert new node in list
- * Input arg:  string = new string to be added to list
- */
-void Insert(struct list_s* list_p, char string[]) {
-   // struct node* current = list_p -> head;
-   struct node* temp_p;
-
-   temp_p = malloc(sizeof(struct node));
-   temp_p -> string = malloc((strlen(string) + 1) * sizeof(char));
-   strcpy(temp_p -> string, string);
-
-	if (list_p -> head == NULL && list_p -> tail == NULL) {
-        temp_p -> next_p = NULL;
-		list_p -> head = list_p -> tail = temp_p;
-	} else {
-		list_p -> tail -> next_p = temp_p;
-		list_p -> tail = temp_p;
-	}
-
-}  /* Insert */
-
-
-/*-----------------------------------------------------------------*/
-/* Function:   Get_string
- * Purpose:    Read the next string in stdin
- * Out arg:    string = next string in stdin
- */
-void GetString(char string[]) {
-
-   printf("Please enter a string: ");
-   scanf("%s", string);
-}  /* Get_string */
-
-
-/*-----------------------------------------------------------------*/
-/* Function:   Print
- * Purpose:    Print the contents of the nodes in the list
- * Input arg:  list_p = pointers to first and last nodes in list
- */
-void Print(struct list_s* list_p) {
-   struct node* current = list_p -> head;
-
-   while (current != NULL) {
-      printf("%s ", current -> string);
-      current = current -> next_p;
-   }
-   printf("\n");
-}  /* Print */
-
-/*-----------------------------------------------------------------*/
-/* Function:   Print
- * Purpose:    Print the contents of the nodes in the list
- * Input arg:  list_p = pointers to first and last nodes in list
- */
-void Print2(struct list_s* list_p, int size) {
-   struct node* current = list_p -> head;
-   int i = 0;
-   while (current != NULL && i<size) {
-      printf("%s ", current -> string);
-      current = current -> next_p;
-      i++;
-   }
-   printf("\n");
-}  /* Print */
-
-
-/*-----------------------------------------------------------------*/
-/* Function:   Free
- * Purpose:    Free up all storage that was used by the list and nodes
- */
-void Free(struct list_s* list_p) {
-   struct node* current;
-   struct node* follow;
-
-   current = list_p -> head; 
-   while (current != NULL) {
-      follow = current -> next_p;
-
-      free(current -> string);
-      free(current);
-      current = follow;
-   }
-
-   list_p -> head = list_p -> tail = NULL;
-}  /* Free */
-
-
+
+ // * Compile:  gcc -g -Wall -o ll linkedlist.c -lm -lpthread
+ // * Run:      ./ll [thread_count] [n]
+/*Write a program that implements merge sort on a linked list of strings.
+Input will be a list of strings.  You should build a linked list from the input list,
+print the input list, sort it using one of the two algorithms,
+and print the result and the time required for the sort.  The input list will come from stdin.
+The command line may include an "n" that will suppress output of the lists and just print the elapsed time for the sort.
+
+The merge sort algorithm is a little different from the standard algorithm.
+Instead of recursively splitting the list in half,  you double the list size with each pass:
+
+      for (list_size = 2; list_size <= n; list_size *= 2) {
+            Sort(elements list_size/2, ..., list_size);
+            Merge sublist 0,...,list_size/2-1 and sublist list_size/2, ... , list_size);
+      }
+You can initially assume that the list size is a power of two,
+but in order to get full credit, you need to correctly sort a list of any positive integer size.
+*/
+/* Notes:
+ * 1.  The sort only changes next_p links:  strings are never copied,
+ *     and no nodes are allocated or freed.  The sort is stable, and
+ *     any number of strings can be sorted.
+ * 2.  The runs are merged in the same order as the doubling passes,
+ *     but a run of 2^k nodes is merged as soon as there are two of
+ *     them, instead of after a pass over the whole list.  So a merge
+ *     works on nodes that were used recently and are probably still
+ *     in cache.  bins[k] holds the sorted run of 2^k nodes that's
+ *     waiting for a partner, and at the end the runs left in bins are
+ *     merged, smallest first.  This is the order used by the classic
+ *     list sorts, e.g. in the SGI STL.
+ * 3.  If thread_count > 1, the list is cut into thread_count runs of
+ *     (almost) equal size, and each thread sorts one.  Then the runs
+ *     are merged pairwise:  at stride 1, 2, 4, ..., thread my_rank
+ *     merges its run with the run of thread my_rank + stride, once
+ *     that thread is done, if my_rank is a multiple of 2*stride.
+ *     Thread 0 ends up with the sorted list.
+ * 4.  With "n" on the command line the prompts aren't printed either,
+ *     so a large list can be read from a file quickly.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "timer.h"
+
+const int max = 100;
+
+#define MAX_BINS 64      /* bins[k] holds a run of 2^k nodes */
+
+struct node {
+   char  *string;
+   struct node* next_p;
+};
+
+struct list_s {
+   struct node* head;
+   struct node* tail;
+};
+
+/* Shared by the sorting threads */
+int thread_count = 1;
+struct node** heads;     /* First node of each thread's run */
+struct node** tails;     /* Last node of each thread's run */
+int* done;               /* done[r] = 1 when thread r's run is ready */
+pthread_mutex_t done_mutex;
+pthread_cond_t done_cond;
+
+int print_lists = 1;
+
+void Usage(char* prog_name);
+struct node* Merge(struct node* left, struct node* right, struct node** tail_p);
+struct node* Split(struct node* head, int count);
+struct node* Last(struct node* head);
+struct node* Sort_run(struct node* head, struct node** tail_p);
+void Sort(struct list_s* list_p, int size);
+void* Sort_thread(void* rank);
+void Insert(struct list_s* list_p, char string[]);
+void GetString(char string[]);
+void Print(struct list_s* list_p);
+void Free(struct list_s* list_p);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+	char string[max];
+	struct list_s* list = malloc(sizeof(struct list_s));
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "n") == 0)
+			print_lists = 0;
+		else if ((thread_count = strtol(argv[i], NULL, 10)) <= 0)
+			Usage(argv[0]);
+	}
+
+	list -> head = list -> tail = NULL; //empty list
+
+	double start = 0;
+	double finish = 0;
+
+	if (print_lists) printf("Enter a size for the list\n");  //get the size of the list
+	int size;
+	if (scanf("%d", &size) != 1 || size < 0) size = 0;
+
+	for(i = 0; i < size; i ++){
+		GetString(string);
+		Insert(list, string);
+	}
+
+	if (print_lists) {
+		printf("This is the unsorted list.\n");
+		Print(list);  //prints unsorted input list
+	}
+
+	GET_TIME(start);  //starts the wall clock time
+
+	Sort(list, size);  //sorts the input list
+
+	GET_TIME(finish);  //stops the wall clock time
+
+	if (print_lists) {
+		printf("This is the sorted list.\n");
+		Print(list);  //prints the sorted list after merge
+	}
+
+	Free(list);
+	free(list);
+
+	printf("Elapsed time = %e seconds\n ", finish-start);
+
+	return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------*/
+/* Function:   Usage
+ * Purpose:    Print a message showing the command line arguments
+ *             and quit
+ */
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s [thread_count] [n]\n", prog_name);
+   fprintf(stderr, "   thread_count:  number of threads (default 1)\n");
+   fprintf(stderr, "   n:  don't print prompts or lists\n");
+   exit(0);
+}  /* Usage */
+
+
+/*-----------------------------------------------------------------*/
+/* Function:   Merge
+ * Purpose:    Combine two sorted lists into one by relinking their
+ *             nodes
+ * Input args: left, right = heads of the two lists, which must end
+ *                with NULL
+ * Out arg:    tail_p = last node of the merged list, or NULL if it's
+ *                empty.  If tail_p is NULL, the last node isn't found.
+ * Return val: Head of the merged list
+ * Note:       If two strings are equal, the one from left comes first
+ */
+struct node* Merge(struct node* left, struct node* right, struct node** tail_p) {
+   struct node dummy;
+   struct node* tail = &dummy;
+
+   while (left != NULL && right != NULL) {
+      if (strcmp(right -> string, left -> string) < 0) {
+         tail -> next_p = right;
+         right = right -> next_p;
+      } else {
+         tail -> next_p = left;
+         left = left -> next_p;
+      }
+      tail = tail -> next_p;
+   }
+   tail -> next_p = (left != NULL) ? left : right;
+
+   if (tail_p != NULL)
+      *tail_p = Last((tail == &dummy) ? dummy.next_p : tail);
+   return dummy.next_p;
+}  /* Merge */
+
+
+/*------------------------------------------------------------------
+ * Function:     Split
+ * Purpose:      Cut a list after its first count nodes
+ * Input args:   head = first node of the list (may be NULL)
+ *               count = number of nodes to keep
+ * Return val:   First node of the rest of the list, or NULL if the
+ *               list has count nodes or fewer
+ */
+struct node* Split(struct node* head, int count) {
+   struct node* rest;
+   int i;
+
+   for (i = 1; head != NULL && i < count; i++)
+      head = head -> next_p;
+   if (head == NULL) return NULL;
+   rest = head -> next_p;
+   head -> next_p = NULL;
+   return rest;
+}  /* Split */
+
+
+/*------------------------------------------------------------------
+ * Function:     Last
+ * Purpose:      Find the last node of a list
+ * Return val:   The last node, or NULL if the list is empty
+ */
+struct node* Last(struct node* head) {
+   if (head == NULL) return NULL;
+   while (head -> next_p != NULL)
+      head = head -> next_p;
+   return head;
+}  /* Last */
+
+
+/*------------------------------------------------------------------
+ * Function:     Sort_run
+ * Purpose:      Bottom-up merge sort of a list:  merge runs of 1 node,
+ *               then runs of 2, 4, ..., until one run is left (see
+ *               note 2)
+ * Input args:   head = first node of the list, which must end with NULL
+ * Out arg:      tail_p = last node of the sorted list
+ * Return val:   First node of the sorted list
+ */
+struct node* Sort_run(struct node* head, struct node** tail_p) {
+   struct node* bins[MAX_BINS];
+   struct node* carry;
+   int k, used = 0;
+
+   while (head != NULL) {
+      carry = head;
+      head = head -> next_p;
+      carry -> next_p = NULL;
+      for (k = 0; k < used && bins[k] != NULL; k++) {
+         carry = Merge(bins[k], carry, NULL);
+         bins[k] = NULL;
+      }
+      bins[k] = carry;
+      if (k == used) used++;
+   }
+
+   head = NULL;
+   for (k = 0; k < used; k++)
+      if (bins[k] != NULL)
+         head = Merge(bins[k], head, NULL);
+   *tail_p = Last(head);
+   return head;
+}  /* Sort_run */
+
+
+/*------------------------------------------------------------------
+ * Function:     Sort
+ * Purpose:      Sort the list, using thread_count threads
+ * Input args:   size = number of nodes in the list
+ * In/out arg:   list_p = list being sorted
+ */
+void Sort(struct list_s* list_p, int size) {
+   pthread_t* thread_handles;
+   struct node* rest;
+   long thread;
+   int run_size;
+
+   if (thread_count == 1) {
+      list_p -> head = Sort_run(list_p -> head, &list_p -> tail);
+      return;
+   }
+
+   heads = malloc(thread_count*sizeof(struct node*));
+   tails = malloc(thread_count*sizeof(struct node*));
+   done = calloc(thread_count, sizeof(int));
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   pthread_mutex_init(&done_mutex, NULL);
+   pthread_cond_init(&done_cond, NULL);
+
+   /* Cut the list into thread_count runs */
+   rest = list_p -> head;
+   for (thread = 0; thread < thread_count; thread++) {
+      run_size = size/thread_count + (thread < size % thread_count);
+      heads[thread] = (run_size > 0) ? rest : NULL;
+      if (run_size > 0) rest = Split(rest, run_size);
+   }
+
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL, Sort_thread,
+            (void*) thread);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_join(thread_handles[thread], NULL);
+
+   list_p -> head = heads[0];
+   list_p -> tail = tails[0];
+
+   pthread_mutex_destroy(&done_mutex);
+   pthread_cond_destroy(&done_cond);
+   free(thread_handles);
+   free(done);
+   free(tails);
+   free(heads);
+}  /* Sort */
+
+
+/*------------------------------------------------------------------
+ * Function:     Sort_thread
+ * Purpose:      Sort this thread's run, and then merge it with the
+ *               runs of other threads (see note 3)
+ * In arg:       rank
+ * Global vars:  heads, tails, done, thread_count
+ */
+void* Sort_thread(void* rank) {
+   long my_rank = (long) rank;
+   long partner;
+   int stride;
+
+   heads[my_rank] = Sort_run(heads[my_rank], &tails[my_rank]);
+
+   for (stride = 1; my_rank % (2*stride) == 0 &&
+         my_rank + stride < thread_count; stride *= 2) {
+      partner = my_rank + stride;
+      pthread_mutex_lock(&done_mutex);
+      while (!done[partner])
+         pthread_cond_wait(&done_cond, &done_mutex);
+      pthread_mutex_unlock(&done_mutex);
+      heads[my_rank] = Merge(heads[my_rank], heads[partner],
+            &tails[my_rank]);
+   }
+
+   pthread_mutex_lock(&done_mutex);
+   done[my_rank] = 1;
+   pthread_cond_broadcast(&done_cond);
+   pthread_mutex_unlock(&done_mutex);
+
+   return NULL;
+}  /* Sort_thread */
+
+
+/*-----------------------------------------------------------------*/
+/* Function:   Insert
+ * Purpose:    Insert new node in list
+ * Input arg:  string = new string to be added to list
+ */
+void Insert(struct list_s* list_p, char string[]) {
+   // struct node* current = list_p -> head;
+   struct node* temp_p;
+
+   temp_p = malloc(sizeof(struct node));
+   temp_p -> string = malloc((strlen(string) + 1) * sizeof(char));
+   strcpy(temp_p -> string, string);
+   temp_p -> next_p = NULL;
+
+	if (list_p -> head == NULL && list_p -> tail == NULL) {
+		list_p -> head = list_p -> tail = temp_p;
+	} else {
+		list_p -> tail -> next_p = temp_p;
+		list_p -> tail = temp_p;
+	}
+
+}  /* Insert */
+
+
+/*-----------------------------------------------------------------*/
+/* Function:   Get_string
+ * Purpose:    Read the next string in stdin
+ * Out arg:    string = next string in stdin
+ */
+void GetString(char string[]) {
+
+   if (print_lists) printf("Please enter a string: ");
+   if (scanf("%99s", string) != 1) string[0] = '\0';
+}  /* Get_string */
+
+
+/*-----------------------------------------------------------------*/
+/* Function:   Print
+ * Purpose:    Print the contents of the nodes in the list
+ * Input arg:  list_p = pointers to first and last nodes in list
+ */
+void Print(struct list_s* list_p) {
+   struct node* current = list_p -> head;
+
+   while (current != NULL) {
+      printf("%s ", current -> string);
+      current = current -> next_p;
+   }
+   printf("\n");
+}  /* Print */
+
+
+/*-----------------------------------------------------------------*/
+/* Function:   Free
+ * Purpose:    Free up all storage that was used by the list and nodes
+ */
+void Free(struct list_s* list_p) {
+   struct node* current;
+   struct node* follow;
+
+   current = list_p -> head;
+   while (current != NULL) {
+      follow = current -> next_p;
+
+      free(current -> string);
+      free(current);
+      current = follow;
+   }
+
+   list_p -> head = list_p -> tail = NULL;
+}  /* Free */
@@ -0,0 +1,131 @@
+/* File:     list_sweep.c
+ *
+ * Purpose:  Run the multithreaded linked list programs with 1, 2, 4,
+ *           ... threads, and write their throughput and latency as
+ *           comma-separated values, so that the programs can be compared
+ *           without typing their input by hand.
+ *
+ * Compile:  gcc -g -Wall -o list_sweep list_sweep.c
+ * Usage:    ./list_sweep <max_threads> <keys in main> <total ops>
+ *              <search percent> <insert percent> [key distribution]
+ * Input:    none
+ * Output:   One line of CSV for each program and thread count:
+ *
+ *              program,threads,distribution,keys_in_main,total_ops,
+ *              search,insert,elapsed,ops_per_sec,mean_latency_us
+ *
+ * Notes:
+ *    1.  The programs (pth_linked_list_one_mut, pth_linked_list_mult_mut,
+ *        pth_linked_list_rwl, pth_linked_list_lock_free and
+ *        pth_bitmap_set) should be compiled and in the current directory.
+ *    2.  Each program is started with popen, and its input is piped to
+ *        it by the shell.  The elapsed time is read from its output.
+ *    3.  The thread counts are the powers of 2 less than max_threads,
+ *        followed by max_threads.
+ *    4.  The key distribution is passed to the programs (see
+ *        workload.c).  The default is u (uniform).
+ *    5.  The distribution is quoted, since it can contain a comma.
+ *    6.  mean_latency_us is the mean time for one op, as seen by one
+ *        thread:  elapsed*threads/total_ops.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_CMD 512
+#define MAX_LINE 256
+
+const char* programs[] = {
+   "./pth_linked_list_one_mut",
+   "./pth_linked_list_mult_mut",
+   "./pth_linked_list_rwl",
+   "./pth_linked_list_lock_free",
+   "./pth_bitmap_set"
+};
+/* Arguments that go between the thread count and the distribution */
+const char* options[] = {"", "", "p ", "", ""};
+const int program_count = sizeof(programs)/sizeof(programs[0]);
+
+void   Usage(char* prog_name);
+double Run(int p, int threads, char* dist, int keys_in_main,
+         int total_ops, double search, double insert);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   int max_threads, keys_in_main, total_ops;
+   double search, insert, elapsed;
+   char* dist = "u";
+   int p, threads;
+
+   if (argc != 6 && argc != 7) Usage(argv[0]);
+   max_threads = strtol(argv[1], NULL, 10);
+   keys_in_main = strtol(argv[2], NULL, 10);
+   total_ops = strtol(argv[3], NULL, 10);
+   search = strtod(argv[4], NULL);
+   insert = strtod(argv[5], NULL);
+   if (argc == 7) dist = argv[6];
+   if (max_threads < 1 || total_ops < 1) Usage(argv[0]);
+
+   printf("program,threads,distribution,keys_in_main,total_ops,"
+          "search,insert,elapsed,ops_per_sec,mean_latency_us\n");
+   for (p = 0; p < program_count; p++) {
+      threads = 1;
+      while (1) {
+         elapsed = Run(p, threads, dist, keys_in_main,
+               total_ops, search, insert);
+         if (elapsed >= 0) {
+            printf("%s,%d,\"%s\",%d,%d,%.3f,%.3f,%e,%e,%e\n",
+                  programs[p] + 2, threads, dist, keys_in_main,
+                  total_ops, search, insert, elapsed, total_ops/elapsed,
+                  1.0e6*elapsed*threads/total_ops);
+            fflush(stdout);
+         }
+         if (threads == max_threads) break;
+         threads = (2*threads < max_threads) ? 2*threads : max_threads;
+      }
+   }
+
+   return 0;
+}  /* main */
+
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <max_threads> <keys in main> <total ops>\n",
+         prog_name);
+   fprintf(stderr, "   <search percent> <insert percent> [key distribution]\n");
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Run
+ * Purpose:    Run one of the programs and find its elapsed time
+ * In args:    p, the subscript of the program in programs[]
+ *             threads, dist, keys_in_main, total_ops, search, insert
+ * Return val: The elapsed time, or -1 if the program didn't report one
+ */
+double Run(int p, int threads, char* dist, int keys_in_main,
+      int total_ops, double search, double insert) {
+   char command[MAX_CMD];
+   char line[MAX_LINE];
+   double elapsed = -1.0;
+   FILE* out;
+
+   snprintf(command, MAX_CMD, "printf '%d\\n%d\\n%f\\n%f\\n' | %s %d %s%s",
+         keys_in_main, total_ops, search, insert, programs[p], threads,
+         options[p], dist);
+#  ifdef DEBUG
+   fprintf(stderr, "Running %s\n", command);
+#  endif
+   out = popen(command, "r");
+   if (out == NULL) {
+      fprintf(stderr, "Can't run %s\n", programs[p]);
+      return -1.0;
+   }
+   while (fgets(line, MAX_LINE, out) != NULL)
+      sscanf(line, "Elapsed time = %lf", &elapsed);
+   pclose(out);
+
+   if (elapsed < 0)
+      fprintf(stderr, "%s with %d threads didn't report a time\n",
+            programs[p], threads);
+   return elapsed;
+}  /* Run */
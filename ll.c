@@ -19,18 +19,43 @@
  *    1.  Repeated strings are *not* allowed in the list
  *    2.  DEBUG compile flag used.  To get debug output compile with
  *        -DDEBUG command line flag.
+ *    3.  A node and its string are allocated together:  the string
+ *        is stored in the node, after the pointers.  Nodes are carved
+ *        out of ARENA_CHUNK byte chunks, and a deleted node is put on
+ *        a free list for nodes of its size, rounded up to a multiple
+ *        of ALIGN bytes, so there's no call to malloc or free for most
+ *        inserts and deletes.  The chunks are freed by Free_arena.
+ *    4.  Each node also stores the first 8 chars of its string as a
+ *        big-endian 64-bit int, padded with zeroes (the prefix).  So
+ *        comparing the prefixes of two strings gives the same order as
+ *        strcmp, unless they're equal, and strcmp is only called when
+ *        two strings have the same first 8 chars.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 const int STRING_MAX = 100;
 
+#define ARENA_CHUNK 65536    /* Bytes in each chunk of the arena */
+#define ALIGN 16             /* Node sizes are multiples of ALIGN */
+#define SIZE_CLASSES 16      /* Larger nodes are malloced */
+
 struct list_node_s {
-   char*  data;
+   uint64_t prefix;
    struct list_node_s* prev_p;
    struct list_node_s* next_p;
+   char   data[];
+};
+
+/* Storage for the nodes */
+struct arena_s {
+   char*  chunk;             /* Current chunk */
+   int    used;              /* Bytes used in current chunk */
+   struct list_node_s* free_p[SIZE_CLASSES];
 };
+struct arena_s arena = {NULL, ARENA_CHUNK, {NULL}};
 
 struct list_s {
    struct list_node_s* h_p;
@@ -45,6 +70,10 @@ void Free_list(struct list_s* list_p);
 char Get_command(void);
 void Get_string(char string[]);
 void Free_node(struct list_node_s* node_p);
+void Free_arena(void);
+int  Size_class(int size);
+uint64_t Prefix(char string[]);
+int  Compare(uint64_t prefix, char string[], struct list_node_s* node_p);
 struct list_node_s* Allocate_node(int size);
 void Print_node(char title[], struct list_node_s* node_p);
 
@@ -93,6 +122,7 @@ int main(void) {
       command = Get_command();
    }
    Free_list(&list);
+   Free_arena();
 
    return 0;
 }  /* main */
@@ -100,16 +130,35 @@ int main(void) {
 
 /*-----------------------------------------------------------------*/
 /* Function:   Allocate_node
- * Purpose:    Allocate storage for a list node
+ * Purpose:    Allocate storage for a list node and its string
  * Input arg:  size = number of chars needed in data member (including
  *                storage for the terminating null)
  * Return val: Pointer to the new node
+ * Note:       The node is taken from the free list for its size, or
+ *             from the current chunk of the arena.  When the chunk is
+ *             used up a new one is allocated.  The first ALIGN bytes
+ *             of a chunk point to the previous chunk.
  */
 struct list_node_s* Allocate_node(int size) {
    struct list_node_s* temp_p;
-
-   temp_p = malloc(sizeof(struct list_node_s));
-   temp_p->data = malloc(size*sizeof(char));
+   int c = Size_class(size);
+   char* chunk;
+
+   if (c >= SIZE_CLASSES) {
+      temp_p = malloc(sizeof(struct list_node_s) + size);
+   } else if (arena.free_p[c] != NULL) {
+      temp_p = arena.free_p[c];
+      arena.free_p[c] = temp_p->next_p;
+   } else {
+      if (arena.used + c*ALIGN > ARENA_CHUNK) {
+         chunk = aligned_alloc(ALIGN, ARENA_CHUNK);
+         *((char**) chunk) = arena.chunk;
+         arena.chunk = chunk;
+         arena.used = ALIGN;
+      }
+      temp_p = (struct list_node_s*) (arena.chunk + arena.used);
+      arena.used += c*ALIGN;
+   }
    temp_p->prev_p = NULL;
    temp_p->next_p = NULL;
    return temp_p;
@@ -127,20 +176,24 @@ struct list_node_s* Allocate_node(int size) {
 void Insert(struct list_s* list_p, char string[]) {
    struct list_node_s* curr_p = list_p->h_p;
    struct list_node_s* temp_p;
+   uint64_t prefix = Prefix(string);
+   int order;
 
 #  ifdef DEBUG
    printf("In Insert, string = %s\n");
 #  endif
 
-   while (curr_p != NULL)
-      if (strcmp(string, curr_p->data) == 0) {
+   while (curr_p != NULL) {
+      order = Compare(prefix, string, curr_p);
+      if (order == 0) {
          printf("%s is already in the list\n", string);
          return;  
-      } else if (strcmp(string, curr_p->data) < 0) {
+      } else if (order < 0) {
          break;  /* string alphabetically precedes node */
       } else {
          curr_p = curr_p->next_p;
       }
+   }
 
 #  ifdef DEBUG
    Print_node("Exited Insert loop: curr_p", curr_p);
@@ -148,6 +201,7 @@ void Insert(struct list_s* list_p, char string[]) {
 
    temp_p = Allocate_node(strlen(string) + 1);
    strcpy(temp_p->data, string);
+   temp_p->prefix = prefix;
 
    if ( list_p->h_p == NULL ) {
       /* list is empty */
@@ -198,28 +252,101 @@ void Print(struct list_s* list_p) {
  */
 int  Member(struct list_s* list_p, char string[]) {
    struct list_node_s* curr_p;
+   uint64_t prefix = Prefix(string);
+   int order;
 
    curr_p = list_p->h_p;
-   while (curr_p != NULL) 
-      if (strcmp(string, curr_p->data) == 0)
+   while (curr_p != NULL) {
+      order = Compare(prefix, string, curr_p);
+      if (order == 0)
          return 1;
-      else if (strcmp(string, curr_p->data) < 0)
+      else if (order < 0)
          return 0;
       else
          curr_p = curr_p->next_p;
+   }
    return 0;
 }  /* Member */
 
 /*-----------------------------------------------------------------*/
 /* Function:   Free_node
- * Purpose:    Free storage used by a node of the list
+ * Purpose:    Put a node on the free list for its size, or free it if
+ *             it was malloced
  * In/out arg: node_p = pointer to node to be freed
  */
 void Free_node(struct list_node_s* node_p) {
-   free(node_p->data);
-   free(node_p);
+   int c = Size_class(strlen(node_p->data) + 1);
+
+   if (c >= SIZE_CLASSES) {
+      free(node_p);
+   } else {
+      node_p->next_p = arena.free_p[c];
+      arena.free_p[c] = node_p;
+   }
 }  /* Free_node */
 
+/*-----------------------------------------------------------------*/
+/* Function:   Free_arena
+ * Purpose:    Free all the chunks of the arena.  Any nodes that are
+ *             still in a list can't be used after this.
+ */
+void Free_arena(void) {
+   char* chunk;
+   int c;
+
+   while (arena.chunk != NULL) {
+      chunk = arena.chunk;
+      arena.chunk = *((char**) chunk);
+      free(chunk);
+   }
+   arena.used = ARENA_CHUNK;
+   for (c = 0; c < SIZE_CLASSES; c++)
+      arena.free_p[c] = NULL;
+}  /* Free_arena */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Size_class
+ * Purpose:    Find the number of ALIGN byte units needed by a node
+ *             whose string takes size chars (including the null)
+ */
+int Size_class(int size) {
+   return (sizeof(struct list_node_s) + size + ALIGN - 1)/ALIGN;
+}  /* Size_class */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Prefix
+ * Purpose:    Pack the first 8 chars of string into a 64-bit int, with
+ *             the first char in the most significant byte.  If the
+ *             string is shorter, the remaining bytes are 0.
+ */
+uint64_t Prefix(char string[]) {
+   uint64_t prefix = 0;
+   int i;
+
+   for (i = 0; i < 8 && string[i] != '\0'; i++)
+      prefix |= (uint64_t) (unsigned char) string[i] << (56 - 8*i);
+   return prefix;
+}  /* Prefix */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Compare
+ * Purpose:    Compare string, whose prefix is prefix, to the string
+ *             in a node
+ * Return val: < 0, 0, or > 0, like strcmp(string, node_p->data)
+ * Note:       If the prefixes are equal and the last byte is 0, both
+ *             strings have fewer than 8 chars, and they're equal.
+ */
+int Compare(uint64_t prefix, char string[], struct list_node_s* node_p) {
+   if (prefix < node_p->prefix)
+      return -1;
+   else if (prefix > node_p->prefix)
+      return 1;
+   else if ((prefix & 0xff) == 0)
+      return 0;
+   else
+      return strcmp(string + 8, node_p->data + 8);
+}  /* Compare */
+
 /*-----------------------------------------------------------------*/
 /* Function:   Delete
  * Purpose:    Delete node containing string.
@@ -232,17 +359,21 @@ void Free_node(struct list_node_s* node_p) {
  */
 void Delete(struct list_s* list_p, char string[]) {
    struct list_node_s* curr_p = list_p->h_p;
+   uint64_t prefix = Prefix(string);
+   int order;
 
    /* Find string */
-   while (curr_p != NULL) 
-      if (strcmp(string, curr_p->data) == 0) {
+   while (curr_p != NULL) {
+      order = Compare(prefix, string, curr_p);
+      if (order == 0) {
          break;
-      } else if (strcmp(string, curr_p->data) < 0) {
+      } else if (order < 0) {
          printf("%s is not in the list\n", string);
          return;
       } else {
          curr_p = curr_p->next_p;
       }
+   }
    
    if (curr_p == NULL) {
       printf("%s is not in the list\n", string);
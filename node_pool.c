@@ -0,0 +1,202 @@
+/* File:     node_pool.c
+ *
+ * Purpose:  Implement a pool allocator for fixed-size list nodes.  Each
+ *           thread allocates from and frees to its own free list, so
+ *           in the common case Pool_alloc and Pool_free don't need
+ *           any locks.
+ *
+ * Pool_init:     set the size of the nodes.  Call once, before any
+ *                thread calls Pool_alloc
+ * Pool_alloc:    return a cache-line-aligned node
+ * Pool_free:     return a node to the calling thread's free list
+ * Pool_destroy:  free all the storage used by the pool.  Only call
+ *                this when no thread is using the pool.
+ *
+ * Notes:
+ * 1.  Node storage is allocated in slabs of SLAB_NODES nodes.  Each
+ *     node is rounded up to a multiple of CACHE_LINE bytes, so two
+ *     nodes never share a cache line.
+ * 2.  Free nodes are linked through their first word.
+ * 3.  There is a global "depot" of batches of BATCH free nodes,
+ *     protected by a mutex.  When a thread's free list is empty, it
+ *     takes a whole batch from the depot (or carves a new slab into
+ *     batches).  When a thread's free list grows to 2*BATCH nodes, it
+ *     returns a batch to the depot.  So a thread that only frees
+ *     nodes allocated by other threads doesn't hoard them.
+ * 4.  A node can be freed by any thread, not just the one that
+ *     allocated it.
+ * 5.  Nodes left on a thread's free list when the thread terminates
+ *     aren't reused:  they're freed with their slab by Pool_destroy.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "node_pool.h"
+
+#define CACHE_LINE 64
+#define BATCH 64
+#define SLAB_NODES (16*BATCH)
+
+struct free_node_s {
+   struct free_node_s* next;
+};
+
+struct free_list_s {
+   struct free_node_s* head;
+   int                 count;
+};
+
+/* The depot */
+static pthread_mutex_t     depot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct free_node_s** depot = NULL;    /* Stack of batches */
+static int                 depot_count = 0;
+static int                 depot_max = 0;
+static void**              slabs = NULL;     /* For Pool_destroy */
+static int                 slab_count = 0;
+static int                 slab_max = 0;
+static size_t              slot_size = CACHE_LINE;
+
+static __thread struct free_list_s my_free = {NULL, 0};
+
+static void Push_batch(struct free_node_s* batch);
+static struct free_node_s* Pop_batch(void);
+static void New_slab(void);
+
+/*-----------------------------------------------------------------*/
+/* Function:   Pool_init
+ * Purpose:    Set the size of the slots in the pool
+ * In arg:     node_size, the number of bytes in a node
+ */
+void Pool_init(size_t node_size) {
+   if (node_size < sizeof(struct free_node_s))
+      node_size = sizeof(struct free_node_s);
+   slot_size = (node_size + CACHE_LINE - 1)/CACHE_LINE*CACHE_LINE;
+}  /* Pool_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Pool_alloc
+ * Purpose:    Get a node from the calling thread's free list, refilling
+ *             it from the depot if it's empty
+ * Return val: Pointer to the node
+ */
+void* Pool_alloc(void) {
+   struct free_node_s* node;
+
+   if (my_free.head == NULL) {
+      pthread_mutex_lock(&depot_mutex);
+      if (depot_count == 0) New_slab();
+      my_free.head = Pop_batch();
+      pthread_mutex_unlock(&depot_mutex);
+      my_free.count = BATCH;
+   }
+   node = my_free.head;
+   my_free.head = node->next;
+   my_free.count--;
+   return node;
+}  /* Pool_alloc */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Pool_free
+ * Purpose:    Put a node on the calling thread's free list.  If the
+ *             list is too long, return a batch to the depot.
+ * In arg:     node
+ */
+void Pool_free(void* node) {
+   struct free_node_s* temp = node;
+   struct free_node_s* batch;
+   int i;
+
+   temp->next = my_free.head;
+   my_free.head = temp;
+   my_free.count++;
+
+   if (my_free.count >= 2*BATCH) {
+      batch = my_free.head;
+      for (i = 0; i < BATCH-1; i++)
+         temp = temp->next;
+      my_free.head = temp->next;
+      temp->next = NULL;
+      my_free.count -= BATCH;
+      pthread_mutex_lock(&depot_mutex);
+      Push_batch(batch);
+      pthread_mutex_unlock(&depot_mutex);
+   }
+}  /* Pool_free */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Pool_destroy
+ * Purpose:    Free the slabs and the depot
+ * Note:       The calling thread's free list is emptied.  The free
+ *             lists of other threads will refer to freed storage,
+ *             so the pool must not be used again by them.
+ */
+void Pool_destroy(void) {
+   int i;
+
+   for (i = 0; i < slab_count; i++)
+      free(slabs[i]);
+   free(slabs);
+   free(depot);
+   slabs = NULL;
+   depot = NULL;
+   slab_count = slab_max = 0;
+   depot_count = depot_max = 0;
+   my_free.head = NULL;
+   my_free.count = 0;
+}  /* Pool_destroy */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Push_batch
+ * Purpose:    Push a NULL-terminated chain of BATCH nodes onto the
+ *             depot
+ * Assumption: The caller holds depot_mutex
+ */
+static void Push_batch(struct free_node_s* batch) {
+   if (depot_count == depot_max) {
+      depot_max = (depot_max == 0) ? SLAB_NODES/BATCH : 2*depot_max;
+      depot = realloc(depot, depot_max*sizeof(struct free_node_s*));
+   }
+   depot[depot_count++] = batch;
+}  /* Push_batch */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Pop_batch
+ * Purpose:    Pop a chain of BATCH nodes from the depot
+ * Assumption: The caller holds depot_mutex and the depot isn't empty
+ */
+static struct free_node_s* Pop_batch(void) {
+   return depot[--depot_count];
+}  /* Pop_batch */
+
+/*-----------------------------------------------------------------*/
+/* Function:   New_slab
+ * Purpose:    Allocate a slab and push its nodes onto the depot in
+ *             batches.  Nodes in a batch are contiguous, so a thread
+ *             that allocates a run of nodes gets neighboring slots.
+ * Assumption: The caller holds depot_mutex
+ */
+static void New_slab(void) {
+   char* slab;
+   struct free_node_s* node;
+   int i, j;
+
+   slab = aligned_alloc(CACHE_LINE, SLAB_NODES*slot_size);
+   if (slab == NULL) {
+      fprintf(stderr, "Pool_alloc:  out of memory\n");
+      exit(-1);
+   }
+   if (slab_count == slab_max) {
+      slab_max = (slab_max == 0) ? 16 : 2*slab_max;
+      slabs = realloc(slabs, slab_max*sizeof(void*));
+   }
+   slabs[slab_count++] = slab;
+
+   for (i = 0; i < SLAB_NODES; i += BATCH) {
+      for (j = i; j < i + BATCH; j++) {
+         node = (struct free_node_s*) (slab + j*slot_size);
+         node->next = (j < i + BATCH - 1) ?
+            (struct free_node_s*) (slab + (j+1)*slot_size) : NULL;
+      }
+      Push_batch((struct free_node_s*) (slab + i*slot_size));
+   }
+}  /* New_slab */
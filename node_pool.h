@@ -0,0 +1,16 @@
+/* File:     node_pool.h
+ * Purpose:  Header file for node_pool.c, which implements a pool
+ *           allocator for fixed-size list nodes with per-thread
+ *           free lists.
+ */
+#ifndef _NODE_POOL_H_
+#define _NODE_POOL_H_
+
+#include <stddef.h>
+
+void  Pool_init(size_t node_size);
+void* Pool_alloc(void);
+void  Pool_free(void* node);
+void  Pool_destroy(void);
+
+#endif
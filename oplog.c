@@ -0,0 +1,227 @@
+/* File:     oplog.c
+ *
+ * Purpose:  Record the commands given to a linked list program in a
+ *           compact binary file, and replay them from the file much
+ *           faster than they can be read with scanf.
+ *
+ * Oplog_create:      open a new log for recording
+ * Oplog_put_op:      record a command
+ * Oplog_put_int:     record an int argument
+ * Oplog_put_string:  record a string argument
+ * Oplog_open:        open a recorded log for replaying
+ * Oplog_get_op:      return the next command, or 'q' at the end of the
+ *                    log
+ * Oplog_get_int:     return the next int argument
+ * Oplog_get_string:  copy the next string argument
+ * Oplog_close:       finish recording or replaying and free the log
+ *
+ * Notes:
+ * 1.  A log starts with the 4 bytes in MAGIC.  After that, it's just
+ *     the commands and their arguments in the order they were given:
+ *     there are no record boundaries, so the program that replays a
+ *     log must ask for the same things, in the same order, as the
+ *     program that recorded it.
+ * 2.  A command is a single byte.
+ * 3.  An int is zigzag encoded, so that small negative values are
+ *     small, and then written 7 bits at a time, least significant
+ *     first.  The high bit of each byte is set if more bytes follow.
+ *     So an int takes 1 to 5 bytes.
+ * 4.  A string is its length, written like an int, followed by its
+ *     chars.  The terminating null isn't written.
+ * 5.  A log is replayed from a read-only mmap of the whole file, so
+ *     getting the next token is just a few loads and shifts.
+ * 6.  Replaying doesn't read past the end of the log:  at the end,
+ *     Oplog_get_op returns 'q', Oplog_get_int returns 0, and
+ *     Oplog_get_string returns an empty string.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "oplog.h"
+
+#define MAGIC "OPL1"
+#define MAGIC_SIZE 4
+
+struct oplog_s {
+   FILE* file;                 /* Recording */
+   unsigned char* start;       /* Replaying:  the mapped file */
+   unsigned char* curr;
+   unsigned char* end;
+};
+
+static void     Put_varint(struct oplog_s* log_p, unsigned val);
+static unsigned Get_varint(struct oplog_s* log_p);
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_create
+ * Purpose:    Create (or truncate) a file, and open it for recording
+ * Return val: Pointer to the log
+ */
+struct oplog_s* Oplog_create(char path[]) {
+   struct oplog_s* log_p = malloc(sizeof(struct oplog_s));
+
+   log_p->file = fopen(path, "wb");
+   if (log_p->file == NULL) {
+      fprintf(stderr, "Oplog_create:  can't open %s\n", path);
+      exit(-1);
+   }
+   log_p->start = log_p->curr = log_p->end = NULL;
+   fwrite(MAGIC, 1, MAGIC_SIZE, log_p->file);
+   return log_p;
+}  /* Oplog_create */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_put_op
+ * Purpose:    Record a single char command
+ */
+void Oplog_put_op(struct oplog_s* log_p, char op) {
+   putc(op, log_p->file);
+}  /* Oplog_put_op */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_put_int
+ * Purpose:    Record an int argument
+ */
+void Oplog_put_int(struct oplog_s* log_p, int val) {
+   /* Zigzag:  0, -1, 1, -2, ... -> 0, 1, 2, 3, ... */
+   Put_varint(log_p, ((unsigned) val << 1) ^ (unsigned) (val >> 31));
+}  /* Oplog_put_int */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_put_string
+ * Purpose:    Record a string argument
+ */
+void Oplog_put_string(struct oplog_s* log_p, char string[]) {
+   unsigned len = strlen(string);
+
+   Put_varint(log_p, len);
+   fwrite(string, 1, len, log_p->file);
+}  /* Oplog_put_string */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_open
+ * Purpose:    Map a recorded log into memory for replaying
+ * Return val: Pointer to the log
+ */
+struct oplog_s* Oplog_open(char path[]) {
+   struct oplog_s* log_p = malloc(sizeof(struct oplog_s));
+   struct stat buf;
+   int fd;
+
+   fd = open(path, O_RDONLY);
+   if (fd < 0 || fstat(fd, &buf) < 0) {
+      fprintf(stderr, "Oplog_open:  can't open %s\n", path);
+      exit(-1);
+   }
+   if (buf.st_size < MAGIC_SIZE) {
+      fprintf(stderr, "Oplog_open:  %s isn't an op log\n", path);
+      exit(-1);
+   }
+   log_p->start = mmap(NULL, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (log_p->start == MAP_FAILED) {
+      fprintf(stderr, "Oplog_open:  can't map %s\n", path);
+      exit(-1);
+   }
+   if (memcmp(log_p->start, MAGIC, MAGIC_SIZE) != 0) {
+      fprintf(stderr, "Oplog_open:  %s isn't an op log\n", path);
+      exit(-1);
+   }
+   madvise(log_p->start, buf.st_size, MADV_SEQUENTIAL);
+   log_p->file = NULL;
+   log_p->curr = log_p->start + MAGIC_SIZE;
+   log_p->end = log_p->start + buf.st_size;
+   return log_p;
+}  /* Oplog_open */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_get_op
+ * Purpose:    Get the next command from the log
+ * Return val: The command, or 'q' if the whole log has been replayed
+ */
+char Oplog_get_op(struct oplog_s* log_p) {
+   if (log_p->curr >= log_p->end) return 'q';
+   return *log_p->curr++;
+}  /* Oplog_get_op */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_get_int
+ * Purpose:    Get the next int argument from the log
+ */
+int Oplog_get_int(struct oplog_s* log_p) {
+   unsigned val = Get_varint(log_p);
+
+   return (int) (val >> 1) ^ -(int) (val & 1);
+}  /* Oplog_get_int */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_get_string
+ * Purpose:    Get the next string argument from the log
+ * In arg:     max, the number of chars in string, including the
+ *             terminating null.  Longer strings are truncated.  max
+ *             must be at least 1.
+ * Out arg:    string
+ */
+void Oplog_get_string(struct oplog_s* log_p, char string[], int max) {
+   unsigned len, room, copy;
+
+   if (max < 1) {
+      fprintf(stderr, "Oplog_get_string:  max = %d, must be >= 1\n", max);
+      exit(-1);
+   }
+   len = Get_varint(log_p);
+   room = log_p->end - log_p->curr;
+   if (len > room) len = room;
+   copy = (len < (unsigned) max - 1) ? len : (unsigned) max - 1;
+   memcpy(string, log_p->curr, copy);
+   string[copy] = '\0';
+   log_p->curr += len;
+}  /* Oplog_get_string */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Oplog_close
+ * Purpose:    Flush and close a log that's being recorded, or unmap a
+ *             log that's being replayed, and free the log
+ */
+void Oplog_close(struct oplog_s* log_p) {
+   if (log_p->file != NULL)
+      fclose(log_p->file);
+   else
+      munmap(log_p->start, log_p->end - log_p->start);
+   free(log_p);
+}  /* Oplog_close */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Put_varint
+ * Purpose:    Write val 7 bits at a time, least significant first
+ */
+static void Put_varint(struct oplog_s* log_p, unsigned val) {
+   while (val >= 0x80) {
+      putc((val & 0x7f) | 0x80, log_p->file);
+      val >>= 7;
+   }
+   putc(val, log_p->file);
+}  /* Put_varint */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Get_varint
+ * Purpose:    Read a value written by Put_varint
+ * Return val: The value, or 0 if the log ends first
+ */
+static unsigned Get_varint(struct oplog_s* log_p) {
+   unsigned val = 0;
+   int shift = 0;
+   unsigned char byte;
+
+   do {
+      if (log_p->curr >= log_p->end) return 0;
+      byte = *log_p->curr++;
+      val |= (unsigned) (byte & 0x7f) << shift;
+      shift += 7;
+   } while ((byte & 0x80) && shift < 35);
+   return val;
+}  /* Get_varint */
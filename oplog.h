@@ -0,0 +1,25 @@
+/* File:     oplog.h
+ * Purpose:  Header file for oplog.c, which records the commands given
+ *           to the linked list programs in a compact binary file, and
+ *           replays them from the file.
+ */
+#ifndef _OPLOG_H_
+#define _OPLOG_H_
+
+struct oplog_s;
+
+/* Recording */
+struct oplog_s* Oplog_create(char path[]);
+void Oplog_put_op(struct oplog_s* log_p, char op);
+void Oplog_put_int(struct oplog_s* log_p, int val);
+void Oplog_put_string(struct oplog_s* log_p, char string[]);
+
+/* Replaying */
+struct oplog_s* Oplog_open(char path[]);
+char Oplog_get_op(struct oplog_s* log_p);
+int  Oplog_get_int(struct oplog_s* log_p);
+void Oplog_get_string(struct oplog_s* log_p, char string[], int max);
+
+void Oplog_close(struct oplog_s* log_p);
+
+#endif
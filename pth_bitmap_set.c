@@ -0,0 +1,442 @@
+/* File:     pth_bitmap_set.c
+ *
+ * Purpose:  Implement a multi-threaded sorted set of ints with the
+ *           same ops as the linked list programs:  insert, print,
+ *           member, delete, free list.  Since every key is less than
+ *           MAX_KEY, this version stores the set as a bitmap with one
+ *           bit for each possible key, and member, insert and delete
+ *           are each a single atomic operation on one word.
+ *
+ * Compile:  gcc -g -Wall -o pth_bitmap_set pth_bitmap_set.c my_rand.c
+ *              workload.c -lpthread -lm
+ * Usage:    ./pth_bitmap_set <thread_count> [key distribution]
+ * Input:    total number of keys inserted by main thread
+ *           total number of ops
+ *           percent of ops that are search, insert (remainder are delete)
+ * Output:   Elapsed time to carry out the ops
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the set
+ *    2.  DEBUG compile flag used.  To get debug output compile with
+ *        -DDEBUG command line flag.
+ *    3.  The random function is not threadsafe.  So this program
+ *        uses a simple linear congruential generator.
+ *    4.  -DOUTPUT flag to gcc will show the set before and after
+ *        threads have worked on it.
+ *    5.  No locks are used.  Insert and Delete use gcc's atomic
+ *        fetch-or and fetch-and builtins, and Member is an atomic load.
+ *        With MAX_KEY = 10^8 the bitmap uses 12.5 MB.
+ *    6.  There are two levels of "summary" counts:  super_count[s] is
+ *        the number of keys in superblock s (SUPER_BITS bits, one
+ *        cache line of the bitmap), and block_count[b] is the number of
+ *        keys in block b (BLOCK_BITS bits).  Insert and Delete update
+ *        the counts after they change a bit.  Print and Is_empty use
+ *        the counts to skip empty parts of the bitmap, and Rank and
+ *        Select use them to find the number of keys less than a given
+ *        key, and the key with a given rank.
+ *    7.  The counts may briefly disagree with the bitmap while other
+ *        threads are inserting or deleting, so Print, Is_empty, Rank
+ *        and Select should *not* be called when multiple threads are
+ *        accessing the set.
+ *    8.  The optional second argument selects the distribution of the
+ *        keys used by the threads (see workload.c):  u (uniform, the
+ *        default), z[theta] (Zipfian), s (sequential), or h[f,p] (hot
+ *        set).  The keys inserted by the main thread are uniform.
+ *    9.  Compile with -DLATENCY, and add histogram.c to the command
+ *        line, to time every op and print the p50, p99 and p99.9
+ *        latencies of each type of op (see histogram.c).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "my_rand.h"
+#include "workload.h"
+#ifdef LATENCY
+#include "histogram.h"
+#endif
+#include "timer.h"
+
+/* Random ints are less than MAX_KEY */
+const int MAX_KEY = 100000000;
+
+#define CACHE_LINE 64
+#define WORD_BITS 64
+#define SUPER_WORDS (CACHE_LINE/sizeof(unsigned long))
+#define SUPER_BITS (SUPER_WORDS*WORD_BITS)
+#define BLOCK_SUPERS 64
+#define BLOCK_BITS (BLOCK_SUPERS*SUPER_BITS)
+#define MEMBER_OP 0
+#define INSERT_OP 1
+#define DELETE_OP 2
+#define OP_TYPES 3
+
+/* Per-thread statistics, padded to a multiple of the cache line size */
+struct stats_s {
+   int    count[OP_TYPES];
+#  ifdef LATENCY
+   struct histogram_s latency[OP_TYPES];
+#  endif
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Shared variables */
+unsigned long* bitmap;
+int         word_count, super_total, block_total;
+int*        super_count;
+int*        block_count;
+int         thread_count;
+int         total_ops;
+double      insert_percent;
+double      search_percent;
+double      delete_percent;
+struct      stats_s* stats;
+#ifdef LATENCY
+struct      histogram_s latency[OP_TYPES];
+#endif
+int         member_count = 0, insert_count = 0, delete_count = 0;
+
+/* Setup and cleanup */
+void        Usage(char* prog_name);
+void        Get_input(int* inserts_in_main_p);
+void        Allocate_set(void);
+void        Merge_stats(void);
+
+/* Thread function */
+void*       Thread_work(void* rank);
+
+/* Set operations */
+int         Insert(int value);
+void        Print(void);
+int         Member(int value);
+int         Delete(int value);
+void        Free_list(void);
+int         Is_empty(void);
+int         Rank(int value);
+int         Select(int rank);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long i;
+   int key, success, attempts;
+   pthread_t* thread_handles;
+   int inserts_in_main;
+   unsigned seed = 1;
+   double start, finish;
+
+   if (argc != 2 && argc != 3) Usage(argv[0]);
+   thread_count = strtol(argv[1],NULL,10);
+   if (!Workload_init(argc == 3 ? argv[2] : "u", MAX_KEY, thread_count))
+      Usage(argv[0]);
+
+   Get_input(&inserts_in_main);
+   Allocate_set();
+
+   /* Try to insert inserts_in_main keys, but give up after */
+   /* 2*inserts_in_main attempts.                           */
+   i = attempts = 0;
+   while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
+      key = my_rand(&seed) % MAX_KEY;
+      success = Insert(key);
+      attempts++;
+      if (success) i++;
+   }
+   printf("Inserted %ld keys in empty list\n", i);
+
+#  ifdef OUTPUT
+   printf("Before starting threads, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   stats = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct stats_s));
+
+   GET_TIME(start);
+   for (i = 0; i < thread_count; i++)
+      pthread_create(&thread_handles[i], NULL, Thread_work, (void*) i);
+
+   for (i = 0; i < thread_count; i++)
+      pthread_join(thread_handles[i], NULL);
+   GET_TIME(finish);
+   Merge_stats();
+   printf("Elapsed time = %e seconds\n", finish - start);
+   printf("Total ops = %d\n", total_ops);
+   printf("member ops = %d\n", member_count);
+   printf("insert ops = %d\n", insert_count);
+   printf("delete ops = %d\n", delete_count);
+#  ifdef LATENCY
+   Hist_print("member", &latency[MEMBER_OP]);
+   Hist_print("insert", &latency[INSERT_OP]);
+   Hist_print("delete", &latency[DELETE_OP]);
+#  endif
+
+#  ifdef OUTPUT
+   printf("After threads terminate, list = \n");
+   Print();
+   printf("\n");
+   i = Rank(MAX_KEY);
+   if (i > 0)
+      printf("%ld keys, smallest = %d, median = %d, largest = %d\n",
+            i, Select(0), Select(i/2), Select(i-1));
+#  endif
+
+   Free_list();
+   free(bitmap);
+   free(super_count);
+   free(block_count);
+   free(stats);
+   free(thread_handles);
+
+   return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> [key distribution]\n",
+         prog_name);
+   fprintf(stderr, "   key distribution:  u, z[theta], s, or h[f,p]\n");
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+void Get_input(int* inserts_in_main_p) {
+
+   printf("How many keys should be inserted in the main thread?\n");
+   scanf("%d", inserts_in_main_p);
+   printf("How many ops total should be executed?\n");
+   scanf("%d", &total_ops);
+   printf("Percent of ops that should be searches? (between 0 and 1)\n");
+   scanf("%lf", &search_percent);
+   printf("Percent of ops that should be inserts? (between 0 and 1)\n");
+   scanf("%lf", &insert_percent);
+   delete_percent = 1.0 - (search_percent + insert_percent);
+}  /* Get_input */
+
+/*-----------------------------------------------------------------*/
+/* Allocate an empty bitmap and its summary counts */
+void Allocate_set(void) {
+   super_total = (MAX_KEY + SUPER_BITS - 1)/SUPER_BITS;
+   block_total = (super_total + BLOCK_SUPERS - 1)/BLOCK_SUPERS;
+   word_count = super_total*SUPER_WORDS;
+
+   bitmap = aligned_alloc(CACHE_LINE, word_count*sizeof(unsigned long));
+   super_count = calloc(super_total, sizeof(int));
+   block_count = calloc(block_total, sizeof(int));
+   if (bitmap == NULL || super_count == NULL || block_count == NULL) {
+      fprintf(stderr, "Can't allocate the bitmap\n");
+      exit(-1);
+   }
+   memset(bitmap, 0, word_count*sizeof(unsigned long));
+}  /* Allocate_set */
+
+/*-----------------------------------------------------------------*/
+/* Insert value into set */
+/* If value is not in set, return 1, else return 0 */
+int Insert(int value) {
+   unsigned long bit = 1UL << (value % WORD_BITS);
+   unsigned long old;
+
+   old = __atomic_fetch_or(&bitmap[value/WORD_BITS], bit, __ATOMIC_ACQ_REL);
+   if (old & bit) return 0;
+   __atomic_fetch_add(&super_count[value/SUPER_BITS], 1, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&block_count[value/BLOCK_BITS], 1, __ATOMIC_RELAXED);
+   return 1;
+}  /* Insert */
+
+/*-----------------------------------------------------------------*/
+/* Print the keys in increasing order, skipping empty blocks and */
+/* superblocks                                                   */
+void Print(void) {
+   int b, s, w, bit;
+   int s_end, w_end;
+   unsigned long word;
+
+   printf("list = ");
+
+   for (b = 0; b < block_total; b++) {
+      if (block_count[b] == 0) continue;
+      s_end = (b + 1)*BLOCK_SUPERS;
+      if (s_end > super_total) s_end = super_total;
+      for (s = b*BLOCK_SUPERS; s < s_end; s++) {
+         if (super_count[s] == 0) continue;
+         w_end = (s + 1)*SUPER_WORDS;
+         for (w = s*SUPER_WORDS; w < w_end; w++) {
+            word = bitmap[w];
+            while (word != 0) {
+               bit = __builtin_ctzl(word);
+               printf("%d ", w*WORD_BITS + bit);
+               word &= word - 1;
+            }
+         }
+      }
+   }
+   printf("\n");
+}  /* Print */
+
+
+/*-----------------------------------------------------------------*/
+int  Member(int value) {
+   unsigned long word;
+
+   word = __atomic_load_n(&bitmap[value/WORD_BITS], __ATOMIC_ACQUIRE);
+   if ((word & (1UL << (value % WORD_BITS))) == 0) {
+#     ifdef DEBUG
+      printf("%d is not in the list\n", value);
+#     endif
+      return 0;
+   } else {
+#     ifdef DEBUG
+      printf("%d is in the list\n", value);
+#     endif
+      return 1;
+   }
+}  /* Member */
+
+/*-----------------------------------------------------------------*/
+/* Deletes value from set */
+/* If value is in set, return 1, else return 0 */
+int Delete(int value) {
+   unsigned long bit = 1UL << (value % WORD_BITS);
+   unsigned long old;
+
+   old = __atomic_fetch_and(&bitmap[value/WORD_BITS], ~bit,
+         __ATOMIC_ACQ_REL);
+   if ((old & bit) == 0) return 0;
+   __atomic_fetch_sub(&super_count[value/SUPER_BITS], 1, __ATOMIC_RELAXED);
+   __atomic_fetch_sub(&block_count[value/BLOCK_BITS], 1, __ATOMIC_RELAXED);
+   return 1;
+}  /* Delete */
+
+/*-----------------------------------------------------------------*/
+/* Clear the nonempty superblocks */
+void Free_list(void) {
+   int s;
+
+   for (s = 0; s < super_total; s++)
+      if (super_count[s] != 0) {
+         memset(&bitmap[s*SUPER_WORDS], 0, CACHE_LINE);
+         super_count[s] = 0;
+      }
+   memset(block_count, 0, block_total*sizeof(int));
+}  /* Free_list */
+
+/*-----------------------------------------------------------------*/
+int  Is_empty(void) {
+   int b;
+
+   for (b = 0; b < block_total; b++)
+      if (block_count[b] != 0) return 0;
+   return 1;
+}  /* Is_empty */
+
+/*-----------------------------------------------------------------*/
+/* Return the number of keys in the set that are less than value */
+int Rank(int value) {
+   int b, s, w, rank = 0;
+
+   if (value >= MAX_KEY) value = MAX_KEY;
+   for (b = 0; b < value/BLOCK_BITS; b++)
+      rank += block_count[b];
+   for (s = b*BLOCK_SUPERS; s < value/SUPER_BITS; s++)
+      rank += super_count[s];
+   for (w = s*SUPER_WORDS; w < value/WORD_BITS; w++)
+      rank += __builtin_popcountl(bitmap[w]);
+   if (value % WORD_BITS != 0)
+      rank += __builtin_popcountl(bitmap[w] &
+            ((1UL << (value % WORD_BITS)) - 1));
+   return rank;
+}  /* Rank */
+
+/*-----------------------------------------------------------------*/
+/* Return the key with the given rank, i.e., the key that has rank */
+/* smaller keys in the set.  Return -1 if rank >= number of keys   */
+int Select(int rank) {
+   int b, s, w, count;
+   unsigned long word;
+
+   if (rank < 0) return -1;
+   for (b = 0; b < block_total && rank >= block_count[b]; b++)
+      rank -= block_count[b];
+   if (b == block_total) return -1;
+   for (s = b*BLOCK_SUPERS; rank >= super_count[s]; s++)
+      rank -= super_count[s];
+   for (w = s*SUPER_WORDS; ; w++) {
+      count = __builtin_popcountl(bitmap[w]);
+      if (rank < count) break;
+      rank -= count;
+   }
+
+   /* Clear the rank lowest bits of the word */
+   word = bitmap[w];
+   while (rank-- > 0)
+      word &= word - 1;
+   return w*WORD_BITS + __builtin_ctzl(word);
+}  /* Select */
+
+/*-----------------------------------------------------------------*/
+void* Thread_work(void* rank) {
+   long my_rank = (long) rank;
+   int i, val;
+   double which_op;
+   unsigned seed = my_rank + 1;
+   struct stats_s* my_stats = &stats[my_rank];
+   int op;
+#  ifdef LATENCY
+   unsigned long op_start;
+#  endif
+   int ops_per_thread = total_ops/thread_count;
+
+   for (op = 0; op < OP_TYPES; op++) {
+      my_stats->count[op] = 0;
+#     ifdef LATENCY
+      Hist_init(&my_stats->latency[op]);
+#     endif
+   }
+
+   Workload_start(my_rank);
+   for (i = 0; i < ops_per_thread; i++) {
+      which_op = my_drand(&seed);
+      val = Workload_key(&seed);
+#     ifdef LATENCY
+      op_start = Hist_now();
+#     endif
+      if (which_op < search_percent) {
+         Member(val);
+         op = MEMBER_OP;
+      } else if (which_op < search_percent + insert_percent) {
+         Insert(val);
+         op = INSERT_OP;
+      } else { /* delete */
+         Delete(val);
+         op = DELETE_OP;
+      }
+#     ifdef LATENCY
+      Hist_record(&my_stats->latency[op], Hist_now() - op_start);
+#     endif
+      my_stats->count[op]++;
+   }  /* for */
+
+   return NULL;
+}  /* Thread_work */
+
+/*-----------------------------------------------------------------*/
+/* Add up the threads' op counts, and merge their latency histograms */
+void Merge_stats(void) {
+   int q;
+#  ifdef LATENCY
+   int op;
+
+   for (op = 0; op < OP_TYPES; op++)
+      Hist_init(&latency[op]);
+#  endif
+   for (q = 0; q < thread_count; q++) {
+      member_count += stats[q].count[MEMBER_OP];
+      insert_count += stats[q].count[INSERT_OP];
+      delete_count += stats[q].count[DELETE_OP];
+#     ifdef LATENCY
+      for (op = 0; op < OP_TYPES; op++)
+         Hist_merge(&latency[op], &stats[q].latency[op]);
+#     endif
+   }
+}  /* Merge_stats */
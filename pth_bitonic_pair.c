@@ -0,0 +1,469 @@
+/* File:     pth_bitonic_pair.c
+ *
+ * Purpose:  Implement bitonic sort of a list of ints using Pthreads.
+ *           Instead of barriers, each thread only waits for the
+ *           threads it exchanges data with.
+ *
+ * Compile:  gcc -g -Wall -o pth_bitonic_pair pth_bitonic_pair.c -lpthread
+ * Run:      ./pth_bitonic_pair <thread count> <n> [g] [o]
+ *           n = number of ints in the list 
+ *           If 'g' is included on the command line, the program
+ *              will use a random number generator to generate
+ *              the list to be sorted.
+ *           If 'o' is included on the command line, the program
+ *              will print the original list and the sorted list
+ *
+ * Input:    If 'g' is not on the command line, user should enter
+ *           the elements of the list
+ *           
+ * Output:   If 'o' is included on the command line, the original
+ *           list and the sorted list.  
+ *           The elapsed time for the sort.
+ *
+ * Notes:
+ * 1.  thread_count should be a power of 2
+ * 2.  n = list_size should be evenly divisible by thread_count
+ * 3.  The steps of the sort are numbered 0, 1, 2, ...:  step 0 is
+ *     the local qsort, and each stage of the butterflies is another
+ *     step.  Step g reads buffers[(g-1) % 2] and writes buffers[g % 2],
+ *     and each thread only writes its own block of a buffer.  So
+ *     there's no need for thread 0 to swap the list pointers between
+ *     stages, and the sorted list ends up in buffers[steps % 2].
+ * 4.  done[r].step is the last step thread r has finished.  Before
+ *     step g, a thread waits until
+ *        - its partner at step g has finished step g-1, so the
+ *          partner's block of the input buffer is ready, and
+ *        - its partner at step g-1 has finished step g-1, so the
+ *          partner is no longer reading the block of the output
+ *          buffer that this thread is about to overwrite.
+ *     No other thread reads this thread's blocks, so these are the
+ *     only waits.  The step numbers only increase, so they don't have
+ *     to be reset like the sense of a barrier.
+ * 5.  The counters are padded to a cache line each, so a thread
+ *     spinning on its partner's counter doesn't slow down the other
+ *     threads.  Waiting threads spin for a while and then call
+ *     sched_yield, so the sort still makes progress when there are
+ *     more threads than cores (see spin.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "timer.h"
+#include "spin.h"
+
+/* Random values in the range 0 to RMAX-1 */
+#define RMAX 1000000
+//#define RMAX 100
+
+#define CACHE_LINE 64
+
+struct done_s {
+   int step;
+} __attribute__((aligned(CACHE_LINE)));
+
+int thread_count;
+struct done_s* done;     /* Last step finished by each thread */
+int n;
+int *list1, *list2;
+int *buffers[2];
+
+void Usage(char* prog_name);
+void Get_args(int argc, char *argv[], int* gen_list_p, int* output_list_p);
+void Gen_list(int list[], int n);
+void Read_list(char prompt[], int list[], int n);
+void Print_list(char title[], int list[], int n);
+void *Bitonic_sort(void* rank);
+void Bitonic_sort_incr(int th_count, int dim, int my_first, int local_n,
+      int my_rank, int* step_p, int* last_partner_p);
+void Bitonic_sort_decr(int th_count, int dim, int my_first, int local_n,
+      int my_rank, int* step_p, int* last_partner_p);
+void Merge_split_lo(int my_rank, int my_first, int local_n,
+      int partner, int l_a[], int l_b[]);
+void Merge_split_hi(int my_rank, int my_first, int local_n,
+      int partner, int l_a[], int l_b[]);
+int  Compare(const void* x_p, const void* y_p);
+void Wait_for(int partner, int last_partner, int step);
+void Finish_step(int my_rank, int step);
+int  Steps(void);
+
+/*--------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long       thread;
+   pthread_t* thread_handles; 
+   double     start, finish;
+   int        gen_list, output_list;
+
+   Get_args(argc, argv, &gen_list, &output_list);
+
+   thread_handles = malloc (thread_count*sizeof(pthread_t));
+   done = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct done_s));
+   for (thread = 0; thread < thread_count; thread++)
+      done[thread].step = -1;
+   list1 = malloc(n*sizeof(int));
+   list2 = malloc(n*sizeof(int));
+   buffers[0] = list1;
+   buffers[1] = list2;
+
+   if (gen_list)
+      Gen_list(list1, n);
+   else
+      Read_list("Enter the list", list1, n);
+   if (output_list)
+      Print_list("The input list is", list1, n);
+
+   GET_TIME(start);
+   for (thread = 0; thread < thread_count; thread++)
+      pthread_create(&thread_handles[thread], NULL,
+          Bitonic_sort, (void*) thread);
+
+   for (thread = 0; thread < thread_count; thread++) 
+      pthread_join(thread_handles[thread], NULL);
+   GET_TIME(finish);
+   printf("Elapsed time = %e seconds\n", finish - start);
+
+   if (output_list)
+      Print_list("The sorted list is", buffers[Steps() % 2], n);
+
+   free(list1);
+   free(list2);
+   free(done);
+   free(thread_handles);
+   return 0;
+}  /* main */
+
+
+/*--------------------------------------------------------------------
+ * Function:    Usage
+ * Purpose:     Print command line for function and terminate
+ * In arg:      prog_name
+ */
+void Usage(char* prog_name) {
+
+   fprintf(stderr, "usage: %s <thread count> <n> [g] [o]\n", prog_name);
+   fprintf(stderr, "n = number of elements in list\n");
+   fprintf(stderr, "n should be evenly divisible by thread count\n");
+   fprintf(stderr, "'g':  program should generate the list\n");
+   fprintf(stderr, "'o':  program should output original and sorted lists\n");
+   exit(0);
+}  /* Usage */
+
+/*-------------------------------------------------------------------
+ * Function:    Get_args
+ * Purpose:     Get command line args
+ * In args:     argc, argv
+ * Out args:    gen_list_p, output_list_p
+ * Out global:  n
+ */
+void Get_args(int argc, char *argv[], int* gen_list_p, int* output_list_p) {
+   char c1;
+
+   if (argc < 3 || argc > 5) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+   n = strtol(argv[2], NULL, 10);
+   if (n % thread_count != 0) Usage(argv[0]);
+
+   // if (argc == 3)
+   *gen_list_p = *output_list_p = 0;
+
+   if (argc == 4) {
+      c1 = argv[3][0];
+      if (c1 == 'g') 
+         *gen_list_p = 1;
+      else
+         *output_list_p = 1;
+   } else if (argc == 5) {
+      *gen_list_p = 1;
+      *output_list_p = 1;
+   }
+}  /* Get_args */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Gen_list
+ * Purpose:   Use a random number generator to generate a list of ints
+ * In arg:    n
+ * Out arg:   list
+ * In global: RMAX
+ */
+void Gen_list(int list[], int n) {
+   int i;
+
+   srandom(1);
+   for (i = 0; i < n; i++)
+      list[i] = random() % RMAX;
+}  /* Gen_list */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Read_list
+ * Purpose:   Get a list of ints from stdin
+ * In arg:    n
+ * Out arg:   list
+ */
+void Read_list(char prompt[], int list[], int n) {
+   int i;
+
+   printf("%s\n", prompt);
+   for (i = 0; i < n; i++)
+      scanf("%d", &list[i]);
+}  /* Read_list */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Print_list
+ * Purpose:   Print a list of ints to stdout
+ * In args:   list, n
+ */
+void Print_list(char title[], int list[], int n) {
+   int i;
+
+   printf("%s:\n", title);
+   for (i = 0; i < n; i++)
+      printf("%d ", list[i]);
+   printf("\n");
+}  /* Print_list */
+
+
+/*-----------------------------------------------------------------
+ * Function:     Compare
+ * Purpose:      Compare two ints and determine their relative sizes
+ * In args:      x_p, y_p
+ * Ret val:      -1 if *x_p < *y_p
+ *                0 if *x_p == *y_p
+ *               +1 if *x_p > *y_p
+ * Note:         For use by qsort library function
+ */
+int Compare(const void* x_p, const void* y_p) {
+   int x = *((int*)x_p);
+   int y = *((int*)y_p);
+
+   if (x < y)
+      return -1;
+   else if (x == y)
+      return 0;
+   else /* x > y */
+      return 1;
+}  /* Compare */
+
+
+/*-------------------------------------------------------------------
+ * Function:        Bitonic_sort
+ * Purpose:         Implement bitonic sort of a list of ints
+ * In arg:          rank
+ * In globals:      thread_count, n (list size), list1
+ * Out global:      buffers[Steps() % 2]
+ * Scratch global:  list2
+ * In/out global:   done
+ * Return val:      Ignored
+ */
+void *Bitonic_sort(void* rank) {
+   long tmp = (long) rank;
+   int my_rank = (int) tmp; 
+   int local_n = n/thread_count;
+   int my_first = my_rank*local_n;
+// int my_last = my_first + local_n - 1;
+   unsigned th_count, and_bit, dim;
+   int step = 0;
+   int last_partner = my_rank;
+
+   /* Sort my sublist:  step 0 */
+   qsort(list1 + my_first, local_n, sizeof(int), Compare);  
+   Finish_step(my_rank, step);
+   for (th_count = 2, and_bit = 2, dim = 1; th_count <= thread_count; 
+         th_count <<= 1, and_bit <<= 1, dim++) {
+      if ((my_rank & and_bit) == 0)
+         Bitonic_sort_incr(th_count, dim, my_first, local_n, my_rank,
+               &step, &last_partner);
+      else
+         Bitonic_sort_decr(th_count, dim, my_first, local_n, my_rank,
+               &step, &last_partner);
+   }
+
+   return NULL;
+}  /* Bitonic_sort */
+
+/*-------------------------------------------------------------------
+ * Function:      Bitonic_sort_incr
+ * Purpose:       Use parallel bitonic sort to sort a list into
+ *                   increasing order.  This implements a butterfly
+ *                   communication scheme among the threads
+ * In args:       th_count:  the number of threads participating
+ *                   in this sort
+ *                dim:  base 2 log of th_count
+ *                my_first:  the subscript of my first element in l_a
+ *                local_n:  the number of elements assigned to each
+ *                   thread
+ *                 my_rank:  the calling thread's global rank
+ * In/out args:    step_p:  the last step this thread finished
+ *                 last_partner_p:  this thread's partner in that step
+ * In/out global:  buffers[*step_p % 2] holds the current list.
+ */
+void Bitonic_sort_incr(int th_count, int dim, int my_first, int local_n,
+      int my_rank, int* step_p, int* last_partner_p) {
+   int stage;
+   int partner;
+   unsigned eor_bit = 1 << (dim - 1);
+
+   for (stage = 0; stage < dim; stage++) {
+      partner = my_rank ^ eor_bit;
+      Wait_for(partner, *last_partner_p, *step_p);
+      if (my_rank < partner)
+         Merge_split_lo(my_rank, my_first, local_n, partner,
+               buffers[*step_p % 2], buffers[(*step_p + 1) % 2]);
+      else
+         Merge_split_hi(my_rank, my_first, local_n, partner,
+               buffers[*step_p % 2], buffers[(*step_p + 1) % 2]);
+      eor_bit >>= 1;
+      (*step_p)++;
+      *last_partner_p = partner;
+      Finish_step(my_rank, *step_p);
+#     ifdef DDEBUG
+      printf("Th %d > Th_count = %d, stage = %d, step = %d done\n",
+            my_rank, th_count, stage, *step_p);
+#     endif
+   } 
+       
+}  /* Bitonic_sort_incr */
+
+
+/*-------------------------------------------------------------------
+ * Function:      Bitonic_sort_decr
+ * Purpose:       Use parallel bitonic sort to sort a list into
+ *                   decreasing order.  This implements a butterfly
+ *                   communication scheme among the threads
+ * In args:       th_count:  the number of threads participating
+ *                   in this sort
+ *                dim:  base 2 log of th_count
+ *                my_first:  the subscript of my first element in l_a
+ *                local_n:  the number of elements assigned to each
+ *                   thread
+ *                 my_rank:  the calling thread's global rank
+ * In/out args:    step_p:  the last step this thread finished
+ *                 last_partner_p:  this thread's partner in that step
+ * In/out global:  buffers[*step_p % 2] holds the current list.
+ */
+void Bitonic_sort_decr(int th_count, int dim, int my_first, int local_n,
+      int my_rank, int* step_p, int* last_partner_p) {
+   int stage;
+   int partner;
+   unsigned eor_bit = 1 << (dim - 1);
+
+   for (stage = 0; stage < dim; stage++) {
+      partner = my_rank ^ eor_bit;
+      Wait_for(partner, *last_partner_p, *step_p);
+      if (my_rank > partner)
+         Merge_split_lo(my_rank, my_first, local_n, partner,
+               buffers[*step_p % 2], buffers[(*step_p + 1) % 2]);
+      else
+         Merge_split_hi(my_rank, my_first, local_n, partner,
+               buffers[*step_p % 2], buffers[(*step_p + 1) % 2]);
+      eor_bit >>= 1;
+      (*step_p)++;
+      *last_partner_p = partner;
+      Finish_step(my_rank, *step_p);
+#     ifdef DDEBUG
+      printf("Th %d > Th_count = %d, stage = %d, step = %d done\n",
+            my_rank, th_count, stage, *step_p);
+#     endif
+   } 
+       
+}  /* Bitonic_sort_decr */
+
+
+/*-------------------------------------------------------------------
+ * Function:        Merge_split_lo
+ * Purpose:         Merge two sublists in array l_a keeping lower half
+ *                  in l_b
+ * In args:         partner, local_n, l_a
+ * Out arg:         l_b
+ */
+void Merge_split_lo(int my_rank, int my_first, int local_n,
+      int partner, int l_a[], int l_b[]) {
+   int ai, bi, xi, i;
+
+
+   ai = bi = my_first;
+   xi = partner*local_n;
+
+#  ifdef DDEBUG
+   printf("Th %d > In M_s_lo partner = %d, ai = %d, xi = %d\n",
+         my_rank, partner, ai, xi);
+#  endif    
+   for (i = 0; i < local_n; i++)
+      if (l_a[ai] <= l_a[xi]) {
+         l_b[bi++] = l_a[ai++];
+      } else {
+         l_b[bi++] = l_a[xi++];
+      }
+
+}  /* Merge_split_lo */
+
+
+/*-------------------------------------------------------------------
+ * Function:        Merge_split_hi
+ * Purpose:         Merge two sublists in array l_a keeping upper half
+ *                  in l_b
+ * In args:         partner, local_n, l_a
+ * Out arg:         l_b
+ */
+void Merge_split_hi(int my_rank, int my_first, int local_n,
+      int partner, int l_a[], int l_b[]) {
+   int ai, bi, xi, i;
+
+   ai = bi = my_first + local_n - 1;
+   xi = (partner+1)*local_n - 1;
+
+#  ifdef DDEBUG
+   printf("Th %d > In M_s_hi partner = %d, ai = %d, xi = %d\n",
+         my_rank, partner, ai, xi);
+#  endif    
+
+   for (i = 0; i < local_n; i++)
+      if (l_a[ai] >= l_a[xi])
+         l_b[bi--] = l_a[ai--];
+      else
+         l_b[bi--] = l_a[xi--];
+
+}  /* Merge_split_hi */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Wait_for
+ * Purpose:   Wait until partner and last_partner have both finished
+ *            step (see note 4)
+ * Globals:   done
+ */
+void Wait_for(int partner, int last_partner, int step) {
+   int spins = 0;
+
+   while (__atomic_load_n(&done[partner].step, __ATOMIC_ACQUIRE) < step ||
+         __atomic_load_n(&done[last_partner].step, __ATOMIC_ACQUIRE) < step)
+      Spin_pause(&spins);
+}  /* Wait_for */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Finish_step
+ * Purpose:   Tell the other threads that my_rank has finished step
+ * Globals:   done
+ */
+void Finish_step(int my_rank, int step) {
+   __atomic_store_n(&done[my_rank].step, step, __ATOMIC_RELEASE);
+}  /* Finish_step */
+
+
+/*-------------------------------------------------------------------
+ * Function:  Steps
+ * Purpose:   Find the number of butterfly stages in the sort:
+ *            1 + 2 + ... + log2(thread_count)
+ * Globals:   thread_count
+ */
+int Steps(void) {
+   int th_count, dim, steps = 0;
+
+   for (th_count = 2, dim = 1; th_count <= thread_count;
+         th_count <<= 1, dim++)
+      steps += dim;
+   return steps;
+}  /* Steps */
@@ -0,0 +1,467 @@
+/* File:     pth_linked_list_fc.c
+ *
+ * Purpose:  Implement a multi-threaded sorted linked list of
+ *           ints with ops insert, print, member, delete, free list.
+ *           This version uses flat combining:  a single mutex protects
+ *           the list, but the thread that holds it carries out the
+ *           pending ops of all the threads in one pass over the list.
+ *
+ * Compile:  gcc -g -Wall -o pth_linked_list_fc pth_linked_list_fc.c
+ *              my_rand.c -lpthread
+ * Usage:    ./pth_linked_list_fc <thread_count>
+ * Input:    total number of keys inserted by main thread
+ *           total number of ops carried out
+ *           percent of ops that are searches and inserts (remaining ops
+ *              are deletes).
+ * Output:   Elapsed time to carry out the ops
+ *           Number of combining passes and the mean number of ops
+ *              carried out in each pass
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the list
+ *    2.  DEBUG compile flag used.  To get debug output compile with
+ *        -DDEBUG command line flag.
+ *    3.  Each thread has its own slot, padded to a cache line.  To
+ *        carry out an op, a thread writes the op and the value into
+ *        its slot and sets the slot's pending flag.  Then it either
+ *        acquires the mutex and becomes the "combiner," or waits
+ *        for another combiner to clear the pending flag.
+ *    4.  The combiner collects the pending ops, sorts them by key, and
+ *        carries them out in a single traversal of the list.
+ *    5.  The random function is not threadsafe.  So this program
+ *        uses a simple linear congruential generator.
+ *    6.  -DOUTPUT flag to gcc will show list before and after
+ *        threads have worked on it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include "my_rand.h"
+#include "timer.h"
+
+/* Random ints are less than MAX_KEY */
+const int MAX_KEY = 100000000;
+
+#define CACHE_LINE 64
+
+/* Ops that can be published in a slot */
+#define MEMBER_OP 0
+#define INSERT_OP 1
+#define DELETE_OP 2
+
+/* Struct for list nodes */
+struct list_node_s {
+   int    data;
+   struct list_node_s* next;
+};
+
+/* Struct for a thread's published op */
+struct slot_s {
+   int    op;
+   int    value;
+   int    result;
+   int    pending;
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Shared variables */
+struct      list_node_s* head = NULL;
+int         thread_count;
+int         total_ops;
+double      insert_percent;
+double      search_percent;
+double      delete_percent;
+pthread_mutex_t mutex;
+pthread_mutex_t count_mutex;
+int         member_total=0, insert_total=0, delete_total=0;
+struct      slot_s* slots;
+int*        requests;      /* Only used by the combiner */
+long        combine_passes = 0, combined_ops = 0;
+
+/* Setup and cleanup */
+void        Usage(char* prog_name);
+void        Get_input(int* inserts_in_main_p);
+
+/* Thread function */
+void*       Thread_work(void* rank);
+
+/* Flat combining */
+int         Execute(long my_rank, int op, int value);
+void        Combine(void);
+int         Compare_requests(const void* a_p, const void* b_p);
+
+/* List operations */
+int         Insert(int value);
+void        Print(void);
+int         Member(int value);
+int         Delete(int value);
+void        Free_list(void);
+int         Is_empty(void);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long i;
+   int key, success, attempts;
+   pthread_t* thread_handles;
+   int inserts_in_main;
+   unsigned seed = 1;
+   double start, finish;
+
+   if (argc != 2) Usage(argv[0]);
+   thread_count = strtol(argv[1],NULL,10);
+
+   Get_input(&inserts_in_main);
+
+   /* Try to insert inserts_in_main keys, but give up after */
+   /* 2*inserts_in_main attempts.                           */
+   i = attempts = 0;
+   while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
+      key = my_rand(&seed) % MAX_KEY;
+      success = Insert(key);
+      attempts++;
+      if (success) i++;
+   }
+   printf("Inserted %ld keys in empty list\n", i);
+
+#  ifdef OUTPUT
+   printf("Before starting threads, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   slots = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct slot_s));
+   for (i = 0; i < thread_count; i++)
+      slots[i].pending = 0;
+   requests = malloc(thread_count*sizeof(int));
+   pthread_mutex_init(&mutex, NULL);
+   pthread_mutex_init(&count_mutex, NULL);
+
+   GET_TIME(start);
+   for (i = 0; i < thread_count; i++)
+      pthread_create(&thread_handles[i], NULL, Thread_work, (void*) i);
+
+   for (i = 0; i < thread_count; i++)
+      pthread_join(thread_handles[i], NULL);
+   GET_TIME(finish);
+   printf("Elapsed time = %e seconds\n", finish - start);
+   printf("Total ops = %d\n", total_ops);
+   printf("member ops = %d\n", member_total);
+   printf("insert ops = %d\n", insert_total);
+   printf("delete ops = %d\n", delete_total);
+   printf("combining passes = %ld, mean ops per pass = %.2f\n",
+         combine_passes,
+         combine_passes > 0 ? ((double) combined_ops)/combine_passes : 0.0);
+
+#  ifdef OUTPUT
+   printf("After threads terminate, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   Free_list();
+   pthread_mutex_destroy(&mutex);
+   pthread_mutex_destroy(&count_mutex);
+   free(requests);
+   free(slots);
+   free(thread_handles);
+
+   return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count>\n", prog_name);
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+void Get_input(int* inserts_in_main_p) {
+
+   printf("How many keys should be inserted in the main thread?\n");
+   scanf("%d", inserts_in_main_p);
+   printf("How many total ops should be executed?\n");
+   scanf("%d", &total_ops);
+   printf("Percent of ops that should be searches? (between 0 and 1)\n");
+   scanf("%lf", &search_percent);
+   printf("Percent of ops that should be inserts? (between 0 and 1)\n");
+   scanf("%lf", &insert_percent);
+   delete_percent = 1.0 - (search_percent + insert_percent);
+}  /* Get_input */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Execute
+ * Purpose:     Publish an op in the calling thread's slot and wait
+ *              until it has been carried out, either by this thread
+ *              acting as combiner or by another thread
+ * In args:     my_rank, op, value
+ * Return val:  The return value of the op
+ */
+int Execute(long my_rank, int op, int value) {
+   struct slot_s* my_slot = &slots[my_rank];
+
+   my_slot->op = op;
+   my_slot->value = value;
+   __atomic_store_n(&my_slot->pending, 1, __ATOMIC_RELEASE);
+
+   while (__atomic_load_n(&my_slot->pending, __ATOMIC_ACQUIRE)) {
+      if (pthread_mutex_trylock(&mutex) == 0) {
+         Combine();
+         pthread_mutex_unlock(&mutex);
+      } else {
+         sched_yield();
+      }
+   }
+
+   return my_slot->result;
+}  /* Execute */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Combine
+ * Purpose:     Carry out all the pending ops in the slots.  The ops
+ *              are sorted by key, so a single pass over the list
+ *              serves all of them.
+ * Assumption:  The calling thread holds mutex
+ */
+void Combine(void) {
+   struct list_node_s* curr = head;
+   struct list_node_s* pred = NULL;
+   struct list_node_s* temp;
+   struct slot_s* slot_p;
+   int i, n = 0, value, result;
+
+   for (i = 0; i < thread_count; i++)
+      if (__atomic_load_n(&slots[i].pending, __ATOMIC_ACQUIRE))
+         requests[n++] = i;
+   qsort(requests, n, sizeof(int), Compare_requests);
+
+   for (i = 0; i < n; i++) {
+      slot_p = &slots[requests[i]];
+      value = slot_p->value;
+      while (curr != NULL && curr->data < value) {
+         pred = curr;
+         curr = curr->next;
+      }
+
+      if (slot_p->op == MEMBER_OP) {
+         result = (curr != NULL && curr->data == value);
+      } else if (slot_p->op == INSERT_OP) {
+         if (curr == NULL || curr->data > value) {
+            temp = malloc(sizeof(struct list_node_s));
+            temp->data = value;
+            temp->next = curr;
+            if (pred == NULL)
+               head = temp;
+            else
+               pred->next = temp;
+            curr = temp;
+            result = 1;
+         } else { /* value in list */
+            result = 0;
+         }
+      } else { /* delete */
+         if (curr != NULL && curr->data == value) {
+            temp = curr->next;
+            if (pred == NULL)
+               head = temp;
+            else
+               pred->next = temp;
+#           ifdef DEBUG
+            printf("Freeing %d\n", value);
+#           endif
+            free(curr);
+            curr = temp;
+            result = 1;
+         } else { /* Not in list */
+            result = 0;
+         }
+      }
+
+      slot_p->result = result;
+      __atomic_store_n(&slot_p->pending, 0, __ATOMIC_RELEASE);
+   }
+
+   combine_passes++;
+   combined_ops += n;
+}  /* Combine */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Compare_requests
+ * Purpose:     Compare the keys in two slots, for use by qsort
+ * In args:     a_p, b_p:  pointers to slot subscripts
+ */
+int Compare_requests(const void* a_p, const void* b_p) {
+   int a = slots[*((int*) a_p)].value;
+   int b = slots[*((int*) b_p)].value;
+
+   if (a < b)
+      return -1;
+   else if (a == b)
+      return 0;
+   else /* a > b */
+      return 1;
+}  /* Compare_requests */
+
+/*-----------------------------------------------------------------*/
+/* Insert value in correct numerical location into list */
+/* If value is not in list, return 1, else return 0 */
+int Insert(int value) {
+   struct list_node_s* curr = head;
+   struct list_node_s* pred = NULL;
+   struct list_node_s* temp;
+   int rv = 1;
+
+   while (curr != NULL && curr->data < value) {
+      pred = curr;
+      curr = curr->next;
+   }
+
+   if (curr == NULL || curr->data > value) {
+      temp = malloc(sizeof(struct list_node_s));
+      temp->data = value;
+      temp->next = curr;
+      if (pred == NULL)
+         head = temp;
+      else
+         pred->next = temp;
+   } else { /* value in list */
+      rv = 0;
+   }
+
+   return rv;
+}  /* Insert */
+
+/*-----------------------------------------------------------------*/
+void Print(void) {
+   struct list_node_s* temp;
+
+   printf("list = ");
+
+   temp = head;
+   while (temp != (struct list_node_s*) NULL) {
+      printf("%d ", temp->data);
+      temp = temp->next;
+   }
+   printf("\n");
+}  /* Print */
+
+
+/*-----------------------------------------------------------------*/
+int  Member(int value) {
+   struct list_node_s* temp;
+
+   temp = head;
+   while (temp != NULL && temp->data < value)
+      temp = temp->next;
+
+   if (temp == NULL || temp->data > value) {
+#     ifdef DEBUG
+      printf("%d is not in the list\n", value);
+#     endif
+      return 0;
+   } else {
+#     ifdef DEBUG
+      printf("%d is in the list\n", value);
+#     endif
+      return 1;
+   }
+}  /* Member */
+
+/*-----------------------------------------------------------------*/
+/* Deletes value from list */
+/* If value is in list, return 1, else return 0 */
+int Delete(int value) {
+   struct list_node_s* curr = head;
+   struct list_node_s* pred = NULL;
+   int rv = 1;
+
+   /* Find value */
+   while (curr != NULL && curr->data < value) {
+      pred = curr;
+      curr = curr->next;
+   }
+
+   if (curr != NULL && curr->data == value) {
+      if (pred == NULL) { /* first element in list */
+         head = curr->next;
+#        ifdef DEBUG
+         printf("Freeing %d\n", value);
+#        endif
+         free(curr);
+      } else {
+         pred->next = curr->next;
+#        ifdef DEBUG
+         printf("Freeing %d\n", value);
+#        endif
+         free(curr);
+      }
+   } else { /* Not in list */
+      rv = 0;
+   }
+
+   return rv;
+}  /* Delete */
+
+/*-----------------------------------------------------------------*/
+void Free_list(void) {
+   struct list_node_s* current;
+   struct list_node_s* following;
+
+   if (Is_empty()) return;
+   current = head;
+   following = current->next;
+   while (following != NULL) {
+#     ifdef DEBUG
+      printf("Freeing %d\n", current->data);
+#     endif
+      free(current);
+      current = following;
+      following = current->next;
+   }
+#  ifdef DEBUG
+   printf("Freeing %d\n", current->data);
+#  endif
+   free(current);
+}  /* Free_list */
+
+/*-----------------------------------------------------------------*/
+int  Is_empty(void) {
+   if (head == NULL)
+      return 1;
+   else
+      return 0;
+}  /* Is_empty */
+
+/*-----------------------------------------------------------------*/
+void* Thread_work(void* rank) {
+   long my_rank = (long) rank;
+   int i, val;
+   double which_op;
+   unsigned seed = my_rank + 1;
+   int my_member=0, my_insert=0, my_delete=0;
+   int ops_per_thread = total_ops/thread_count;
+
+   for (i = 0; i < ops_per_thread; i++) {
+      which_op = my_drand(&seed);
+      val = my_rand(&seed) % MAX_KEY;
+      if (which_op < search_percent) {
+         Execute(my_rank, MEMBER_OP, val);
+         my_member++;
+      } else if (which_op < search_percent + insert_percent) {
+         Execute(my_rank, INSERT_OP, val);
+         my_insert++;
+      } else { /* delete */
+         Execute(my_rank, DELETE_OP, val);
+         my_delete++;
+      }
+   }  /* for */
+
+   pthread_mutex_lock(&count_mutex);
+   member_total += my_member;
+   insert_total += my_insert;
+   delete_total += my_delete;
+   pthread_mutex_unlock(&count_mutex);
+
+   return NULL;
+}  /* Thread_work */
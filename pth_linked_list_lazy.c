@@ -0,0 +1,426 @@
+/* File:     pth_linked_list_lazy.c
+ *
+ * Purpose:  Implement a multi-threaded sorted linked list of
+ *           ints with ops insert, print, member, delete, free list.
+ *           This version uses lazy synchronization:  one mutex per
+ *           list node, but traversals don't lock.  Insert and Delete
+ *           only lock the two nodes they change.
+ *
+ * Compile:  gcc -g -Wall -I. -o pth_linked_list_lazy
+ *              pth_linked_list_lazy.c my_rand.c epoch.c -lpthread
+ * Usage:    ./pth_linked_list_lazy <thread_count>
+ * Input:    total number of keys inserted by main thread
+ *           total number of ops carried out
+ *           percent of ops that are searches and inserts (remaining ops
+ *              are deletes.
+ * Output:   Elapsed time to carry out the ops
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the list
+ *    2.  DEBUG compile flag used.  To get debug output compile with
+ *        -DDEBUG command line flag.
+ *    3.  Insert and Delete search the list without locks, then
+ *        lock pred and curr and call Validate to check that neither
+ *        has been deleted and that pred still refers to curr.  If
+ *        validation fails, they start over.
+ *    4.  Delete sets the "marked" member of a node before unlinking
+ *        it, so Member never locks:  a node is in the list iff it's
+ *        reachable and unmarked.
+ *    5.  Deleted nodes may still be referenced by other threads, so
+ *        they're passed to Epoch_retire (see epoch.c) instead of
+ *        being freed.
+ *    6.  The list starts with a sentinel node, head, whose data is
+ *        less than any key.  So every node that's inserted or
+ *        deleted has a predecessor that can be locked.
+ *    7.  The random function is not threadsafe.  So this program
+ *        uses a simple linear congruential generator.
+ *    8.  -DOUTPUT flag to gcc will show list before and after
+ *        threads have worked on it.
+ *    9.  Print and Free_List should *not* be called when multiple
+ *        threads are accessing the list.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "my_rand.h"
+#include "epoch.h"
+#include "timer.h"
+
+/* Random ints are less than MAX_KEY */
+const int MAX_KEY = 100000000;
+
+/* Struct for list nodes */
+struct list_node_s {
+   int    data;
+   int    marked;
+   pthread_mutex_t mutex;
+   struct list_node_s* next;
+};
+
+/* Shared variables */
+struct list_node_s head;
+int         thread_count;
+int         total_ops;
+double      insert_percent;
+double      search_percent;
+double      delete_percent;
+pthread_mutex_t count_mutex;
+int         member_total=0, insert_total=0, delete_total=0;
+
+/* Setup and cleanup */
+void        Usage(char* prog_name);
+void        Get_input(int* inserts_in_main_p);
+
+/* Thread function */
+void*       Thread_work(void* rank);
+
+/* List operations */
+void        Search(int value, struct list_node_s** pred_pp,
+      struct list_node_s** curr_pp);
+void        Lock_ptrs(struct list_node_s* pred, struct list_node_s* curr);
+void        Unlock_ptrs(struct list_node_s* pred, struct list_node_s* curr);
+int         Validate(struct list_node_s* pred, struct list_node_s* curr);
+int         Insert(int value);
+void        Print(void);
+int         Member(int value);
+int         Delete(int value);
+void        Free_node(void* node);
+void        Free_list(void);
+int         Is_empty(void);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long i;
+   int key, success, attempts;
+   pthread_t* thread_handles;
+   int inserts_in_main;
+   unsigned seed = 1;
+   double start, finish;
+
+   if (argc != 2) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+
+   Get_input(&inserts_in_main);
+
+   head.data = -1;
+   head.marked = 0;
+   head.next = NULL;
+   pthread_mutex_init(&head.mutex, NULL);
+   Epoch_init(thread_count, Free_node);
+   Epoch_register(thread_count);
+
+   /* Try to insert inserts_in_main keys, but give up after */
+   /* 2*inserts_in_main attempts.                           */
+   i = attempts = 0;
+   while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
+      key = my_rand(&seed) % MAX_KEY;
+      success = Insert(key);
+      attempts++;
+      if (success) i++;
+   }
+   printf("Inserted %ld keys in empty list\n", i);
+
+#  ifdef OUTPUT
+   printf("Before starting threads, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   pthread_mutex_init(&count_mutex, NULL);
+
+   GET_TIME(start);
+   for (i = 0; i < thread_count; i++)
+      pthread_create(&thread_handles[i], NULL, Thread_work, (void*) i);
+
+   for (i = 0; i < thread_count; i++)
+      pthread_join(thread_handles[i], NULL);
+   GET_TIME(finish);
+   printf("Elapsed time = %e seconds\n", finish - start);
+   printf("Total ops = %d\n", total_ops);
+   printf("member ops = %d\n", member_total);
+   printf("insert ops = %d\n", insert_total);
+   printf("delete ops = %d\n", delete_total);
+
+#  ifdef OUTPUT
+   printf("After threads terminate, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   Free_list();
+   Epoch_destroy();
+   pthread_mutex_destroy(&head.mutex);
+   pthread_mutex_destroy(&count_mutex);
+   free(thread_handles);
+
+   return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count>\n", prog_name);
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+void Get_input(int* inserts_in_main_p) {
+
+   printf("How many keys should be inserted in the main thread?\n");
+   scanf("%d", inserts_in_main_p);
+   printf("How many total ops should the threads execute?\n");
+   scanf("%d", &total_ops);
+   printf("Percent of ops that should be searches? (between 0 and 1)\n");
+   scanf("%lf", &search_percent);
+   printf("Percent of ops that should be inserts? (between 0 and 1)\n");
+   scanf("%lf", &insert_percent);
+   delete_percent = 1.0 - (search_percent + insert_percent);
+}  /* Get_input */
+
+/*-----------------------------------------------------------------*/
+/* Function:  Search
+ * Purpose:   Find pred and curr for Insert or Delete without taking
+ *            any locks:  curr is the first node with data >= value
+ *            (or NULL) and pred is the node before curr
+ */
+void Search(int value, struct list_node_s** pred_pp,
+      struct list_node_s** curr_pp) {
+   struct list_node_s* pred = &head;
+   struct list_node_s* curr = __atomic_load_n(&head.next, __ATOMIC_ACQUIRE);
+
+   while (curr != NULL && curr->data < value) {
+      pred = curr;
+      curr = __atomic_load_n(&curr->next, __ATOMIC_ACQUIRE);
+   }
+   *pred_pp = pred;
+   *curr_pp = curr;
+}  /* Search */
+
+/*-----------------------------------------------------------------*/
+/* Function:  Lock_ptrs
+ * Purpose:   Lock pred and, if it isn't NULL, curr.  Locks are always
+ *            acquired in list order, so there's no deadlock.
+ */
+void Lock_ptrs(struct list_node_s* pred, struct list_node_s* curr) {
+   pthread_mutex_lock(&(pred->mutex));
+   if (curr != NULL)
+      pthread_mutex_lock(&(curr->mutex));
+}  /* Lock_ptrs */
+
+/*-----------------------------------------------------------------*/
+void Unlock_ptrs(struct list_node_s* pred, struct list_node_s* curr) {
+   if (curr != NULL)
+      pthread_mutex_unlock(&(curr->mutex));
+   pthread_mutex_unlock(&(pred->mutex));
+}  /* Unlock_ptrs */
+
+/*-----------------------------------------------------------------*/
+/* Function:  Validate
+ * Purpose:   Check that pred and curr haven't been deleted, and that
+ *            pred still refers to curr
+ * Assumption:  The calling thread holds the locks to pred and curr
+ */
+int Validate(struct list_node_s* pred, struct list_node_s* curr) {
+   return !pred->marked && (curr == NULL || !curr->marked) &&
+      pred->next == curr;
+}  /* Validate */
+
+/*-----------------------------------------------------------------*/
+/* Insert value in correct numerical location into list */
+/* If value is not in list, return 1, else return 0 */
+int Insert(int value) {
+   struct list_node_s* curr;
+   struct list_node_s* pred;
+   struct list_node_s* temp;
+   int rv;
+
+   Epoch_enter();
+   while (1) {
+      Search(value, &pred, &curr);
+      Lock_ptrs(pred, curr);
+      if (Validate(pred, curr)) break;
+      Unlock_ptrs(pred, curr);
+   }
+
+   if (curr == NULL || curr->data > value) {
+#     ifdef DEBUG
+      printf("Inserting %d\n", value);
+#     endif
+      temp = malloc(sizeof(struct list_node_s));
+      pthread_mutex_init(&(temp->mutex), NULL);
+      temp->data = value;
+      temp->marked = 0;
+      temp->next = curr;
+      __atomic_store_n(&pred->next, temp, __ATOMIC_RELEASE);
+      rv = 1;
+   } else { /* value in list */
+      rv = 0;
+   }
+   Unlock_ptrs(pred, curr);
+   Epoch_exit();
+
+   return rv;
+}  /* Insert */
+
+/*-----------------------------------------------------------------*/
+/* Doesn't use locks:  cannot be run with the other threads */
+void Print(void) {
+   struct list_node_s* temp;
+
+   printf("list = ");
+
+   temp = head.next;
+   while (temp != (struct list_node_s*) NULL) {
+      printf("%d ", temp->data);
+      temp = temp->next;
+   }
+   printf("\n");
+}  /* Print */
+
+
+/*-----------------------------------------------------------------*/
+/* Doesn't lock:  a reachable node is in the list iff it's unmarked */
+int  Member(int value) {
+   struct list_node_s* temp;
+   int rv;
+
+   Epoch_enter();
+   temp = __atomic_load_n(&head.next, __ATOMIC_ACQUIRE);
+   while (temp != NULL && temp->data < value)
+      temp = __atomic_load_n(&temp->next, __ATOMIC_ACQUIRE);
+
+   rv = temp != NULL && temp->data == value &&
+         !__atomic_load_n(&temp->marked, __ATOMIC_ACQUIRE);
+   Epoch_exit();
+
+   if (!rv) {
+#     ifdef DEBUG
+      printf("%d is not in the list\n", value);
+#     endif
+      return 0;
+   } else {
+#     ifdef DEBUG
+      printf("%d is in the list\n", value);
+#     endif
+      return 1;
+   }
+}  /* Member */
+
+/*-----------------------------------------------------------------*/
+/* Deletes value from list */
+/* If value is in list, return 1, else return 0 */
+int Delete(int value) {
+   struct list_node_s* curr;
+   struct list_node_s* pred;
+   int rv;
+
+   Epoch_enter();
+   while (1) {
+      Search(value, &pred, &curr);
+      Lock_ptrs(pred, curr);
+      if (Validate(pred, curr)) break;
+      Unlock_ptrs(pred, curr);
+   }
+
+   if (curr != NULL && curr->data == value) {
+#     ifdef DEBUG
+      printf("Deleting %d\n", value);
+#     endif
+      /* Logical deletion, then physical deletion */
+      __atomic_store_n(&curr->marked, 1, __ATOMIC_RELEASE);
+      __atomic_store_n(&pred->next, curr->next, __ATOMIC_RELEASE);
+      Unlock_ptrs(pred, curr);
+      Epoch_retire(curr);
+      rv = 1;
+   } else { /* Not in list */
+      Unlock_ptrs(pred, curr);
+      rv = 0;
+   }
+   Epoch_exit();
+
+   return rv;
+}  /* Delete */
+
+/*-----------------------------------------------------------------*/
+/* Function:  Free_node
+ * Purpose:   Destroy a node's mutex and free it.  Called by the
+ *            epoch module when a retired node can be reclaimed.
+ */
+void Free_node(void* node) {
+   struct list_node_s* node_p = node;
+
+#  ifdef DEBUG
+   printf("Freeing %d\n", node_p->data);
+#  endif
+   pthread_mutex_destroy(&(node_p->mutex));
+   free(node_p);
+}  /* Free_node */
+
+/*-----------------------------------------------------------------*/
+/* Doesn't use locks.  Can only be run when no other threads are
+ * accessing the list
+ */
+void Free_list(void) {
+   struct list_node_s* current;
+   struct list_node_s* following;
+
+   current = head.next;
+   while (current != NULL) {
+      following = current->next;
+      Free_node(current);
+      current = following;
+   }
+   head.next = NULL;
+}  /* Free_list */
+
+/*-----------------------------------------------------------------*/
+int  Is_empty(void) {
+   if (head.next == NULL)
+      return 1;
+   else
+      return 0;
+}  /* Is_empty */
+
+/*-----------------------------------------------------------------*/
+void* Thread_work(void* rank) {
+   long my_rank = (long) rank;
+   int i, val;
+   double which_op;
+   unsigned seed = my_rank + 1;
+   int my_member=0, my_insert=0, my_delete=0;
+   int ops_per_thread = total_ops/thread_count;
+
+   Epoch_register(my_rank);
+   for (i = 0; i < ops_per_thread; i++) {
+      which_op = my_drand(&seed);
+      val = my_rand(&seed) % MAX_KEY;
+      if (which_op < search_percent) {
+#        ifdef DEBUG
+         printf("Thread %ld > Searching for %d\n", my_rank, val);
+#        endif
+         Member(val);
+         my_member++;
+      } else if (which_op < search_percent + insert_percent) {
+#        ifdef DEBUG
+         printf("Thread %ld > Attempting to insert %d\n", my_rank, val);
+#        endif
+         Insert(val);
+         my_insert++;
+      } else { /* delete */
+#        ifdef DEBUG
+         printf("Thread %ld > Attempting to delete %d\n", my_rank, val);
+#        endif
+         Delete(val);
+         my_delete++;
+      }
+   }  /* for */
+
+   pthread_mutex_lock(&count_mutex);
+   member_total += my_member;
+   insert_total += my_insert;
+   delete_total += my_delete;
+   pthread_mutex_unlock(&count_mutex);
+
+   return NULL;
+}  /* Thread_work */
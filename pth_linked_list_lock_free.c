@@ -0,0 +1,478 @@
+/* File:     pth_linked_list_lock_free.c
+ *
+ * Purpose:  Implement a multi-threaded sorted linked list of
+ *           ints with ops insert, print, member, delete, free list.
+ *           This version is lock-free:  it uses the Harris-Michael
+ *           algorithm in which a node is deleted by first marking
+ *           its next pointer and then unlinking it with compare-and-swap
+ *
+ * Compile:  gcc -g -Wall -o pth_linked_list_lock_free
+ *              pth_linked_list_lock_free.c my_rand.c epoch.c workload.c
+ *              -lpthread -lm
+ * Usage:    ./pth_linked_list_lock_free <thread_count> [key distribution]
+ * Input:    total number of keys inserted by main thread
+ *           total number of ops carried out
+ *           percent of ops that are searches and inserts (remaining ops
+ *              are deletes).
+ * Output:   Elapsed time to carry out the ops
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the list
+ *    2.  DEBUG compile flag used.  To get debug output compile with
+ *        -DDEBUG command line flag.
+ *    3.  No locks are used to access the list.  Insert and Delete
+ *        use gcc's __atomic compare-and-swap builtins, and Member
+ *        never writes to shared memory.
+ *    4.  The low-order bit of a node's next pointer is the "marked"
+ *        bit:  if it's set, the node has been logically deleted.
+ *    5.  Another thread may still be reading a node after it has
+ *        been unlinked, so unlinked nodes are passed to Epoch_retire
+ *        (see epoch.c), which frees them once no thread can still
+ *        be reading them.  Insert, Member and Delete are read-side
+ *        critical sections.
+ *    6.  The random function is not threadsafe.  So this program
+ *        uses a simple linear congruential generator.
+ *    7.  -DOUTPUT flag to gcc will show list before and after
+ *        threads have worked on it.
+ *    8.  Print and Free_list should *not* be called when multiple
+ *        threads are accessing the list.
+ *    9.  The optional second argument selects the distribution of the
+ *        keys used by the threads (see workload.c):  u (uniform, the
+ *        default), z[theta] (Zipfian), s (sequential), or h[f,p] (hot
+ *        set).  The keys inserted by the main thread are uniform.
+ *   10.  Each thread keeps its op counts in its own cache-line-aligned
+ *        struct, and main adds them up after the threads finish.
+ *   11.  Compile with -DLATENCY, and add histogram.c to the command
+ *        line, to time every op.  Each thread records the times in its
+ *        own histograms (see histogram.c), and the p50, p99 and p99.9
+ *        latencies of each type of op are printed at the end.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "my_rand.h"
+#include "workload.h"
+#ifdef LATENCY
+#include "histogram.h"
+#endif
+#include "epoch.h"
+#include "timer.h"
+
+/* Random ints are less than MAX_KEY */
+const int MAX_KEY = 100000000;
+
+/* Struct for list nodes */
+struct list_node_s {
+   int    data;
+   struct list_node_s* next;
+};
+
+#define CACHE_LINE 64
+#define MEMBER_OP 0
+#define INSERT_OP 1
+#define DELETE_OP 2
+#define OP_TYPES 3
+
+/* Per-thread statistics, padded to a multiple of the cache line size */
+struct stats_s {
+   int    count[OP_TYPES];
+#  ifdef LATENCY
+   struct histogram_s latency[OP_TYPES];
+#  endif
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Manipulate the marked bit in a next pointer */
+#define Is_marked(p)  ((uintptr_t) (p) & 1)
+#define Marked(p)     ((struct list_node_s*) ((uintptr_t) (p) | 1))
+#define Unmarked(p)   ((struct list_node_s*) ((uintptr_t) (p) & ~(uintptr_t) 1))
+
+/* Shared variables */
+struct      list_node_s* head = NULL;
+int         thread_count;
+int         total_ops;
+double      insert_percent;
+double      search_percent;
+double      delete_percent;
+struct      stats_s* stats;
+#ifdef LATENCY
+struct      histogram_s latency[OP_TYPES];
+#endif
+int         member_total=0, insert_total=0, delete_total=0;
+
+/* Setup and cleanup */
+void        Usage(char* prog_name);
+void        Get_input(int* inserts_in_main_p);
+void        Merge_stats(void);
+
+/* Thread function */
+void*       Thread_work(void* rank);
+
+/* List operations */
+int         Find(int value, struct list_node_s*** pred_ppp,
+      struct list_node_s** curr_pp);
+int         Insert(int value);
+void        Print(void);
+int         Member(int value);
+int         Delete(int value);
+void        Free_list(void);
+int         Is_empty(void);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long i;
+   int key, success, attempts;
+   pthread_t* thread_handles;
+   int inserts_in_main;
+   unsigned seed = 1;
+   double start, finish;
+
+   if (argc != 2 && argc != 3) Usage(argv[0]);
+   thread_count = strtol(argv[1],NULL,10);
+   if (!Workload_init(argc == 3 ? argv[2] : "u", MAX_KEY, thread_count))
+      Usage(argv[0]);
+
+   Get_input(&inserts_in_main);
+   Epoch_init(thread_count, free);
+   Epoch_register(thread_count);
+
+   /* Try to insert inserts_in_main keys, but give up after */
+   /* 2*inserts_in_main attempts.                           */
+   i = attempts = 0;
+   while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
+      key = my_rand(&seed) % MAX_KEY;
+      success = Insert(key);
+      attempts++;
+      if (success) i++;
+   }
+   printf("Inserted %ld keys in empty list\n", i);
+
+#  ifdef OUTPUT
+   printf("Before starting threads, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   stats = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct stats_s));
+
+   GET_TIME(start);
+   for (i = 0; i < thread_count; i++)
+      pthread_create(&thread_handles[i], NULL, Thread_work, (void*) i);
+
+   for (i = 0; i < thread_count; i++)
+      pthread_join(thread_handles[i], NULL);
+   GET_TIME(finish);
+   Merge_stats();
+   printf("Elapsed time = %e seconds\n", finish - start);
+   printf("Total ops = %d\n", total_ops);
+   printf("member ops = %d\n", member_total);
+   printf("insert ops = %d\n", insert_total);
+   printf("delete ops = %d\n", delete_total);
+#  ifdef LATENCY
+   Hist_print("member", &latency[MEMBER_OP]);
+   Hist_print("insert", &latency[INSERT_OP]);
+   Hist_print("delete", &latency[DELETE_OP]);
+#  endif
+
+#  ifdef OUTPUT
+   printf("After threads terminate, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   Free_list();
+   Epoch_destroy();
+   free(stats);
+   free(thread_handles);
+
+   return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> [key distribution]\n",
+         prog_name);
+   fprintf(stderr, "   key distribution:  u, z[theta], s, or h[f,p]\n");
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+void Get_input(int* inserts_in_main_p) {
+
+   printf("How many keys should be inserted in the main thread?\n");
+   scanf("%d", inserts_in_main_p);
+   printf("How many total ops should be executed?\n");
+   scanf("%d", &total_ops);
+   printf("Percent of ops that should be searches? (between 0 and 1)\n");
+   scanf("%lf", &search_percent);
+   printf("Percent of ops that should be inserts? (between 0 and 1)\n");
+   scanf("%lf", &insert_percent);
+   delete_percent = 1.0 - (search_percent + insert_percent);
+}  /* Get_input */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Find
+ * Purpose:     Search for the first node with data >= value.  Marked
+ *              nodes passed along the way are unlinked and retired.
+ * In arg:      value
+ * Out args:    *pred_ppp:  the link (head or a next member) that
+ *                 referred to *curr_pp
+ *              *curr_pp:  the first unmarked node with data >= value,
+ *                 or NULL
+ * Return val:  1 if *curr_pp contains value, 0 otherwise
+ * Note:        Caller must be in an epoch critical section
+ */
+int Find(int value, struct list_node_s*** pred_ppp,
+      struct list_node_s** curr_pp) {
+   struct list_node_s** pred_p;
+   struct list_node_s* curr;
+   struct list_node_s* next;
+
+retry:
+   pred_p = &head;
+   curr = __atomic_load_n(pred_p, __ATOMIC_ACQUIRE);
+   while (curr != NULL) {
+      next = __atomic_load_n(&curr->next, __ATOMIC_ACQUIRE);
+      if (Is_marked(next)) {
+         /* curr has been deleted:  try to unlink it.  If *pred_p  */
+         /* has changed, or pred has been marked, start over       */
+         if (!__atomic_compare_exchange_n(pred_p, &curr, Unmarked(next),
+                  0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            goto retry;
+#        ifdef DEBUG
+         printf("Retiring %d\n", curr->data);
+#        endif
+         Epoch_retire(curr);
+         curr = Unmarked(next);
+      } else {
+         if (curr->data >= value) break;
+         pred_p = &curr->next;
+         curr = next;
+      }
+   }
+
+   *pred_ppp = pred_p;
+   *curr_pp = curr;
+   return curr != NULL && curr->data == value;
+}  /* Find */
+
+/*-----------------------------------------------------------------*/
+/* Insert value in correct numerical location into list */
+/* If value is not in list, return 1, else return 0 */
+int Insert(int value) {
+   struct list_node_s** pred_p;
+   struct list_node_s* curr;
+   struct list_node_s* temp = NULL;
+
+   Epoch_enter();
+   while (1) {
+      if (Find(value, &pred_p, &curr)) {
+         Epoch_exit();
+         free(temp);
+         return 0;
+      }
+      if (temp == NULL) {
+         temp = malloc(sizeof(struct list_node_s));
+         temp->data = value;
+      }
+      temp->next = curr;
+      if (__atomic_compare_exchange_n(pred_p, &curr, temp,
+               0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+         Epoch_exit();
+         return 1;
+      }
+   }
+}  /* Insert */
+
+/*-----------------------------------------------------------------*/
+/* Doesn't use atomics:  cannot be run with the other threads */
+void Print(void) {
+   struct list_node_s* temp;
+
+   printf("list = ");
+
+   temp = head;
+   while (temp != (struct list_node_s*) NULL) {
+      printf("%d ", temp->data);
+      temp = Unmarked(temp->next);
+   }
+   printf("\n");
+}  /* Print */
+
+
+/*-----------------------------------------------------------------*/
+/* Doesn't help unlink marked nodes:  a node whose next pointer is */
+/* marked just isn't in the list                                   */
+int  Member(int value) {
+   struct list_node_s* temp;
+   int rv;
+
+   Epoch_enter();
+   temp = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+   while (temp != NULL && temp->data < value)
+      temp = Unmarked(__atomic_load_n(&temp->next, __ATOMIC_ACQUIRE));
+
+   rv = temp != NULL && temp->data == value &&
+         !Is_marked(__atomic_load_n(&temp->next, __ATOMIC_ACQUIRE));
+   Epoch_exit();
+
+   if (!rv) {
+#     ifdef DEBUG
+      printf("%d is not in the list\n", value);
+#     endif
+      return 0;
+   } else {
+#     ifdef DEBUG
+      printf("%d is in the list\n", value);
+#     endif
+      return 1;
+   }
+}  /* Member */
+
+/*-----------------------------------------------------------------*/
+/* Deletes value from list */
+/* If value is in list, return 1, else return 0 */
+int Delete(int value) {
+   struct list_node_s** pred_p;
+   struct list_node_s* curr;
+   struct list_node_s* next;
+
+   Epoch_enter();
+   while (1) {
+      if (!Find(value, &pred_p, &curr)) {
+         Epoch_exit();
+         return 0;
+      }
+      next = __atomic_load_n(&curr->next, __ATOMIC_ACQUIRE);
+      if (Is_marked(next)) continue;
+
+      /* Logical deletion:  the thread that marks curr owns the delete */
+      if (!__atomic_compare_exchange_n(&curr->next, &next, Marked(next),
+               0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+         continue;
+#     ifdef DEBUG
+      printf("Deleted %d\n", value);
+#     endif
+
+      /* Physical deletion.  If it fails, Find will unlink curr */
+      if (__atomic_compare_exchange_n(pred_p, &curr, next,
+               0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+         Epoch_retire(curr);
+      else
+         Find(value, &pred_p, &curr);
+      Epoch_exit();
+      return 1;
+   }
+}  /* Delete */
+
+/*-----------------------------------------------------------------*/
+/* Doesn't use atomics.  Can only be run when no other threads are
+ * accessing the list
+ */
+void Free_list(void) {
+   struct list_node_s* current;
+   struct list_node_s* following;
+
+   if (Is_empty()) return;
+   current = head;
+   following = Unmarked(current->next);
+   while (following != NULL) {
+#     ifdef DEBUG
+      printf("Freeing %d\n", current->data);
+#     endif
+      free(current);
+      current = following;
+      following = Unmarked(current->next);
+   }
+#  ifdef DEBUG
+   printf("Freeing %d\n", current->data);
+#  endif
+   free(current);
+}  /* Free_list */
+
+/*-----------------------------------------------------------------*/
+int  Is_empty(void) {
+   if (head == NULL)
+      return 1;
+   else
+      return 0;
+}  /* Is_empty */
+
+/*-----------------------------------------------------------------*/
+void* Thread_work(void* rank) {
+   long my_rank = (long) rank;
+   int i, val;
+   double which_op;
+   unsigned seed = my_rank + 1;
+   struct stats_s* my_stats = &stats[my_rank];
+   int op;
+#  ifdef LATENCY
+   unsigned long op_start;
+#  endif
+   int ops_per_thread = total_ops/thread_count;
+
+   for (op = 0; op < OP_TYPES; op++) {
+      my_stats->count[op] = 0;
+#     ifdef LATENCY
+      Hist_init(&my_stats->latency[op]);
+#     endif
+   }
+
+   Workload_start(my_rank);
+   Epoch_register(my_rank);
+   for (i = 0; i < ops_per_thread; i++) {
+      which_op = my_drand(&seed);
+      val = Workload_key(&seed);
+#     ifdef LATENCY
+      op_start = Hist_now();
+#     endif
+      if (which_op < search_percent) {
+#        ifdef DEBUG
+         printf("Thread %ld > Searching for %d\n", my_rank, val);
+#        endif
+         Member(val);
+         op = MEMBER_OP;
+      } else if (which_op < search_percent + insert_percent) {
+#        ifdef DEBUG
+         printf("Thread %ld > Attempting to insert %d\n", my_rank, val);
+#        endif
+         Insert(val);
+         op = INSERT_OP;
+      } else { /* delete */
+#        ifdef DEBUG
+         printf("Thread %ld > Attempting to delete %d\n", my_rank, val);
+#        endif
+         Delete(val);
+         op = DELETE_OP;
+      }
+#     ifdef LATENCY
+      Hist_record(&my_stats->latency[op], Hist_now() - op_start);
+#     endif
+      my_stats->count[op]++;
+   }  /* for */
+
+   return NULL;
+}  /* Thread_work */
+
+/*-----------------------------------------------------------------*/
+/* Add up the threads' op counts, and merge their latency histograms */
+void Merge_stats(void) {
+   int q;
+#  ifdef LATENCY
+   int op;
+
+   for (op = 0; op < OP_TYPES; op++)
+      Hist_init(&latency[op]);
+#  endif
+   for (q = 0; q < thread_count; q++) {
+      member_total += stats[q].count[MEMBER_OP];
+      insert_total += stats[q].count[INSERT_OP];
+      delete_total += stats[q].count[DELETE_OP];
+#     ifdef LATENCY
+      for (op = 0; op < OP_TYPES; op++)
+         Hist_merge(&latency[op], &stats[q].latency[op]);
+#     endif
+   }
+}  /* Merge_stats */
@@ -5,8 +5,8 @@
  *           This version uses one mutex per list node
  * 
  * Compile:  gcc -g -Wall -I. -o pth_linked_list_mult_mut 
- *              pth_linked_list_mult_mut.c my_rand.c -lpthread
- * Usage:    ./pth_linked_list_mult_mut <thread_count>
+ *              pth_linked_list_mult_mut.c my_rand.c workload.c -lpthread -lm
+ * Usage:    ./pth_linked_list_mult_mut <thread_count> [key distribution]
  * Input:    total number of keys inserted by main thread
  *           total number of ops carried out 
  *           percent of ops that are searches and inserts (remaining ops
@@ -22,14 +22,45 @@
  *        uses a simple linear congruential generator.
  *    5.  -DOUTPUT flag to gcc will show list before and after
  *        threads have worked on it.
- *    6.  Only Insert, Member and Delete use locks:  Print and Free_List
- *        should *not* be called when multiple threads are
- *        accessing the list.
+ *    6.  Insert, Member, Delete and Scan use locks:  Free_list and
+ *        Insert_batch should *not* be called when multiple threads are
+ *        accessing the list.  Print uses Scan, so it can be called at
+ *        any time.
+ *    7.  Compile with -DNODE_POOL, and add node_pool.c to the command
+ *        line, to allocate list nodes from the per-thread pools in
+ *        node_pool.c instead of calling malloc and free.
+ *    8.  The optional second argument selects the distribution of the
+ *        keys used by the threads (see workload.c):  u (uniform, the
+ *        default), z[theta] (Zipfian), s (sequential), or h[f,p] (hot
+ *        set).  The keys inserted by the main thread are uniform.
+ *    9.  Each thread keeps its op counts in its own cache-line-aligned
+ *        struct, and main adds them up after the threads finish.
+ *   10.  Compile with -DLATENCY, and add histogram.c to the command
+ *        line, to time every op.  Each thread records the times in its
+ *        own histograms (see histogram.c), and the p50, p99 and p99.9
+ *        latencies of each type of op are printed at the end.
+ *   11.  Scan(lo, hi, callback, arg) calls callback(value, arg) for
+ *        each value in the list with lo <= value <= hi, in increasing
+ *        order, while other threads are using the list.  It moves
+ *        through the list with the same hand-over-hand locking as the
+ *        other ops, starting with head_mutex.  So no op can overtake
+ *        another, and the values passed to callback are exactly the
+ *        values in [lo, hi] at the moment Scan acquired head_mutex.
+ *        The callback is called with a node locked, so it should be
+ *        short, and it must not call the list ops.
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <pthread.h>
 #include "my_rand.h"
+#include "workload.h"
+#ifdef LATENCY
+#include "histogram.h"
+#endif
+#ifdef NODE_POOL
+#include "node_pool.h"
+#endif
 #include "timer.h"
 
 /* Random ints are less than MAX_KEY */
@@ -47,6 +78,20 @@ struct list_node_s {
    struct list_node_s* next;
 };
 
+#define CACHE_LINE 64
+#define MEMBER_OP 0
+#define INSERT_OP 1
+#define DELETE_OP 2
+#define OP_TYPES 3
+
+/* Per-thread statistics, padded to a multiple of the cache line size */
+struct stats_s {
+   int    count[OP_TYPES];
+#  ifdef LATENCY
+   struct histogram_s latency[OP_TYPES];
+#  endif
+} __attribute__((aligned(CACHE_LINE)));
+
 /* Shared variables */
 struct list_node_s* head = NULL;  
 pthread_mutex_t head_mutex;
@@ -55,12 +100,16 @@ int         total_ops;
 double      insert_percent;
 double      search_percent;
 double      delete_percent;
-pthread_mutex_t count_mutex;
+struct      stats_s* stats;
+#ifdef LATENCY
+struct      histogram_s latency[OP_TYPES];
+#endif
 int         member_total=0, insert_total=0, delete_total=0;
 
 /* Setup and cleanup */
 void        Usage(char* prog_name);
 void        Get_input(int* inserts_in_main_p);
+void        Merge_stats(void);
 
 /* Thread function */
 void*       Thread_work(void* rank);
@@ -71,36 +120,55 @@ void        Init_ptrs(struct list_node_s** curr_pp,
 int         Advance_ptrs(struct list_node_s** curr_pp, 
       struct list_node_s** pred_pp);
 int         Insert(int value);
+int         Insert_batch(int values[], int n);
+int         Compare(const void* x_p, const void* y_p);
 void        Print(void);
+void        Print_value(int value, void* arg);
+int         Scan(int lo, int hi, void (*callback)(int value, void* arg),
+               void* arg);
 int         Member(int value);
 int         Delete(int value);
 void        Free_list(void);
+struct list_node_s* Allocate_node(void);
+void        Free_node(struct list_node_s* node);
 int         Is_empty(void);
 
 /*-----------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
    long i; 
-   int key, success, attempts;
+   int j, batch, attempts;
+   int* keys;
    pthread_t* thread_handles;
    int inserts_in_main;
    unsigned seed = 1;
    double start, finish;
 
-   if (argc != 2) Usage(argv[0]);
+   if (argc != 2 && argc != 3) Usage(argv[0]);
    thread_count = strtol(argv[1], NULL, 10);
+   if (!Workload_init(argc == 3 ? argv[2] : "u", MAX_KEY, thread_count))
+      Usage(argv[0]);
 
    Get_input(&inserts_in_main);
+#  ifdef NODE_POOL
+   Pool_init(sizeof(struct list_node_s));
+#  endif
 
    /* Try to insert inserts_in_main keys, but give up after */
-   /* 2*inserts_in_main attempts.                           */
+   /* 2*inserts_in_main attempts.  The keys are generated   */
+   /* in batches, and each batch is inserted in one pass.   */
+   keys = malloc(inserts_in_main*sizeof(int));
    i = attempts = 0;
    pthread_mutex_init(&head_mutex, NULL);
    while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
-      key = my_rand(&seed) % MAX_KEY;
-      success = Insert(key);
-      attempts++;
-      if (success) i++;
+      batch = inserts_in_main - i;
+      if (batch > 2*inserts_in_main - attempts)
+         batch = 2*inserts_in_main - attempts;
+      for (j = 0; j < batch; j++)
+         keys[j] = my_rand(&seed) % MAX_KEY;
+      i += Insert_batch(keys, batch);
+      attempts += batch;
    }
+   free(keys);
    printf("Inserted %ld keys in empty list\n", i);
 
 #  ifdef OUTPUT
@@ -110,7 +178,7 @@ int main(int argc, char* argv[]) {
 #  endif
 
    thread_handles = malloc(thread_count*sizeof(pthread_t));
-   pthread_mutex_init(&count_mutex, NULL);
+   stats = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct stats_s));
 
    GET_TIME(start);
    for (i = 0; i < thread_count; i++)
@@ -119,11 +187,17 @@ int main(int argc, char* argv[]) {
    for (i = 0; i < thread_count; i++)
       pthread_join(thread_handles[i], NULL);
    GET_TIME(finish);
+   Merge_stats();
    printf("Elapsed time = %e seconds\n", finish - start);
    printf("Total ops = %d\n", total_ops);
    printf("member ops = %d\n", member_total);
    printf("insert ops = %d\n", insert_total);
    printf("delete ops = %d\n", delete_total);
+#  ifdef LATENCY
+   Hist_print("member", &latency[MEMBER_OP]);
+   Hist_print("insert", &latency[INSERT_OP]);
+   Hist_print("delete", &latency[DELETE_OP]);
+#  endif
 
 #  ifdef OUTPUT
    printf("After threads terminate, list = \n");
@@ -133,8 +207,11 @@ int main(int argc, char* argv[]) {
 
    Free_list();
    pthread_mutex_destroy(&head_mutex);
-   pthread_mutex_destroy(&count_mutex);
+   free(stats);
    free(thread_handles);
+#  ifdef NODE_POOL
+   Pool_destroy();
+#  endif
 
    return 0;
 }  /* main */
@@ -142,7 +219,9 @@ int main(int argc, char* argv[]) {
 
 /*-----------------------------------------------------------------*/
 void Usage(char* prog_name) {
-   fprintf(stderr, "usage: %s <thread_count>\n", prog_name);
+   fprintf(stderr, "usage: %s <thread_count> [key distribution]\n",
+         prog_name);
+   fprintf(stderr, "   key distribution:  u, z[theta], s, or h[f,p]\n");
    exit(0);
 }  /* Usage */
 
@@ -163,7 +242,7 @@ void Get_input(int* inserts_in_main_p) {
 /*-----------------------------------------------------------------*/
 /* Function:  Init_ptrs
  * Purpose:   Initialize pred and curr pointers before starting the
- *            search carried out by Insert or Delete
+ *            search carried out by Insert, Member, Delete or Scan
  */
 void Init_ptrs(struct list_node_s** curr_pp, struct list_node_s** pred_pp) {
    *pred_pp = NULL;
@@ -176,7 +255,7 @@ void Init_ptrs(struct list_node_s** curr_pp, struct list_node_s** pred_pp) {
 /*-----------------------------------------------------------------*/
 /* Function:  Advance_ptrs
  * Purpose:   Advance the pair of pointers pred and curr during
- *            Insert or Delete
+ *            Insert, Member, Delete or Scan
  * Assumption:  The calling thread already holds the locks to the
  *            nodes referenced by curr_p and pred_p
  */
@@ -225,7 +304,7 @@ int Insert(int value) {
 #     ifdef DEBUG
       printf("Inserting %d\n", value);
 #     endif
-      temp = malloc(sizeof(struct list_node_s));
+      temp = Allocate_node();
       pthread_mutex_init(&(temp->mutex), NULL);
       temp->data = value;
       temp->next = curr;
@@ -253,54 +332,134 @@ int Insert(int value) {
 }  /* Insert */
 
 /*-----------------------------------------------------------------*/
+/* Insert the n values in values[] into the list in a single pass */
+/* values[] is sorted in place.  Return number of values inserted */
 /* Doesn't use locks:  cannot be run with the other threads */
-void Print(void) {
+int Insert_batch(int values[], int n) {
+   struct list_node_s* curr = head;
+   struct list_node_s* pred = NULL;
    struct list_node_s* temp;
+   int i, count = 0;
+
+   qsort(values, n, sizeof(int), Compare);
+   for (i = 0; i < n; i++) {
+      if (i > 0 && values[i] == values[i-1]) continue;
+      while (curr != NULL && curr->data < values[i]) {
+         pred = curr;
+         curr = curr->next;
+      }
+      if (curr == NULL || curr->data > values[i]) {
+         temp = Allocate_node();
+         pthread_mutex_init(&(temp->mutex), NULL);
+         temp->data = values[i];
+         temp->next = curr;
+         if (pred == NULL)
+            head = temp;
+         else
+            pred->next = temp;
+         pred = temp;
+         count++;
+      }
+   }
 
-   printf("list = ");
+   return count;
+}  /* Insert_batch */
 
-   temp = head;
-   while (temp != (struct list_node_s*) NULL) {
-      printf("%d ", temp->data);
-      temp = temp->next;
-   }
+/*-----------------------------------------------------------------*/
+/* Compare two ints, for use by qsort */
+int Compare(const void* x_p, const void* y_p) {
+   int x = *((int*)x_p);
+   int y = *((int*)y_p);
+
+   if (x < y)
+      return -1;
+   else if (x == y)
+      return 0;
+   else /* x > y */
+      return 1;
+}  /* Compare */
+
+/*-----------------------------------------------------------------*/
+/* Uses Scan:  can be run with the other threads */
+void Print(void) {
+
+   printf("list = ");
+   Scan(INT_MIN, INT_MAX, Print_value, NULL);
    printf("\n");
 }  /* Print */
 
+/*-----------------------------------------------------------------*/
+/* Callback for Print */
+void Print_value(int value, void* arg) {
+   printf("%d ", value);
+}  /* Print_value */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Scan
+ * Purpose:     Call callback(value, arg) for each value in the list
+ *              with lo <= value <= hi, in increasing order
+ * In args:     lo, hi, callback, arg
+ * Return val:  The number of values passed to callback
+ * Note:        The values are the ones in the list when Scan acquires
+ *              head_mutex, since the other ops can't pass it
+ */
+int Scan(int lo, int hi, void (*callback)(int value, void* arg),
+      void* arg) {
+   struct list_node_s* curr;
+   struct list_node_s* pred;
+   int count = 0;
+
+   Init_ptrs(&curr, &pred);
+
+   while (curr != NULL && curr->data <= hi) {
+      if (curr->data >= lo) {
+         callback(curr->data, arg);
+         count++;
+      }
+      Advance_ptrs(&curr, &pred);
+   }
+
+   if (curr != NULL)
+      pthread_mutex_unlock(&(curr->mutex));
+   if (pred != NULL)
+      pthread_mutex_unlock(&(pred->mutex));
+   else
+      pthread_mutex_unlock(&head_mutex);
+
+   return count;
+}  /* Scan */
+
 
 /*-----------------------------------------------------------------*/
 int  Member(int value) {
-   struct list_node_s* temp;
+   struct list_node_s* curr;
+   struct list_node_s* pred;
+   int rv = 1;
 
-   pthread_mutex_lock(&head_mutex);
-   temp = head;
-   while (temp != NULL && temp->data < value) {
-      if (temp->next != NULL) 
-         pthread_mutex_lock(&(temp->next->mutex));
-      if (temp == head)
-         pthread_mutex_unlock(&head_mutex);
-      pthread_mutex_unlock(&(temp->mutex));
-      temp = temp->next;
+   Init_ptrs(&curr, &pred);
+
+   while (curr != NULL && curr->data < value) {
+      Advance_ptrs(&curr, &pred);
    }
 
-   if (temp == NULL || temp->data > value) {
+   if (curr == NULL || curr->data > value) {
 #     ifdef DEBUG
       printf("%d is not in the list\n", value);
 #     endif
-      if (temp == head)
-         pthread_mutex_unlock(&head_mutex);
-      if (temp != NULL) 
-         pthread_mutex_unlock(&(temp->mutex));
-      return 0;
+      rv = 0;
    } else {
 #     ifdef DEBUG
       printf("%d is in the list\n", value);
 #     endif
-      if (temp == head)
-         pthread_mutex_unlock(&head_mutex);
-      pthread_mutex_unlock(&(temp->mutex));
-      return 1;
    }
+   if (curr != NULL)
+      pthread_mutex_unlock(&(curr->mutex));
+   if (pred != NULL)
+      pthread_mutex_unlock(&(pred->mutex));
+   else
+      pthread_mutex_unlock(&head_mutex);
+
+   return rv;
 }  /* Member */
 
 /*-----------------------------------------------------------------*/
@@ -327,7 +486,7 @@ int Delete(int value) {
          pthread_mutex_unlock(&head_mutex);
          pthread_mutex_unlock(&(curr->mutex));
          pthread_mutex_destroy(&(curr->mutex));
-         free(curr);
+         Free_node(curr);
       } else { 
          pred->next = curr->next;
          pthread_mutex_unlock(&(pred->mutex));
@@ -336,21 +495,41 @@ int Delete(int value) {
 #        endif
          pthread_mutex_unlock(&(curr->mutex));
          pthread_mutex_destroy(&(curr->mutex));
-         free(curr);
+         Free_node(curr);
       }
    } else { /* Not in list */
       if (pred != NULL)
          pthread_mutex_unlock(&(pred->mutex));
+      else
+         pthread_mutex_unlock(&head_mutex);
       if (curr != NULL)
          pthread_mutex_unlock(&(curr->mutex));
-      if (curr == head)
-         pthread_mutex_unlock(&head_mutex);
       rv = 0;
    }
 
    return rv;
 }  /* Delete */
 
+/*-----------------------------------------------------------------*/
+/* Get storage for a list node from the node pool or malloc */
+struct list_node_s* Allocate_node(void) {
+#  ifdef NODE_POOL
+   return Pool_alloc();
+#  else
+   return malloc(sizeof(struct list_node_s));
+#  endif
+}  /* Allocate_node */
+
+/*-----------------------------------------------------------------*/
+/* Return storage for a list node to the node pool or free it */
+void Free_node(struct list_node_s* node) {
+#  ifdef NODE_POOL
+   Pool_free(node);
+#  else
+   free(node);
+#  endif
+}  /* Free_node */
+
 /*-----------------------------------------------------------------*/
 /* Doesn't use locks.  Can only be run when no other threads are
  * accessing the list
@@ -366,14 +545,14 @@ void Free_list(void) {
 #     ifdef DEBUG
       printf("Freeing %d\n", current->data);
 #     endif
-      free(current);
+      Free_node(current);
       current = following;
       following = current->next;
    }
 #  ifdef DEBUG
    printf("Freeing %d\n", current->data);
 #  endif
-   free(current);
+   Free_node(current);
 }  /* Free_list */
 
 /*-----------------------------------------------------------------*/
@@ -390,38 +569,72 @@ void* Thread_work(void* rank) {
    int i, val;
    double which_op;
    unsigned seed = my_rank + 1;
-   int my_member=0, my_insert=0, my_delete=0;
+   struct stats_s* my_stats = &stats[my_rank];
+   int op;
+#  ifdef LATENCY
+   unsigned long op_start;
+#  endif
    int ops_per_thread = total_ops/thread_count;
 
+   for (op = 0; op < OP_TYPES; op++) {
+      my_stats->count[op] = 0;
+#     ifdef LATENCY
+      Hist_init(&my_stats->latency[op]);
+#     endif
+   }
+
+   Workload_start(my_rank);
    for (i = 0; i < ops_per_thread; i++) {
       which_op = my_drand(&seed);
-      val = my_rand(&seed) % MAX_KEY;
+      val = Workload_key(&seed);
+#     ifdef LATENCY
+      op_start = Hist_now();
+#     endif
       if (which_op < search_percent) {
 #        ifdef DEBUG
          printf("Thread %ld > Searching for %d\n", my_rank, val);
 #        endif
          Member(val);
-         my_member++;
+         op = MEMBER_OP;
       } else if (which_op < search_percent + insert_percent) {
 #        ifdef DEBUG
          printf("Thread %ld > Attempting to insert %d\n", my_rank, val);
 #        endif
          Insert(val);
-         my_insert++;
+         op = INSERT_OP;
       } else { /* delete */
 #        ifdef DEBUG
          printf("Thread %ld > Attempting to delete %d\n", my_rank, val);
 #        endif
          Delete(val);
-         my_delete++;
+         op = DELETE_OP;
       }
+#     ifdef LATENCY
+      Hist_record(&my_stats->latency[op], Hist_now() - op_start);
+#     endif
+      my_stats->count[op]++;
    }  /* for */
 
-   pthread_mutex_lock(&count_mutex);
-   member_total += my_member;
-   insert_total += my_insert;
-   delete_total += my_delete;
-   pthread_mutex_unlock(&count_mutex);
-
    return NULL;
-}  /* Thread_work */
\ No newline at end of file
+}  /* Thread_work */
+
+/*-----------------------------------------------------------------*/
+/* Add up the threads' op counts, and merge their latency histograms */
+void Merge_stats(void) {
+   int q;
+#  ifdef LATENCY
+   int op;
+
+   for (op = 0; op < OP_TYPES; op++)
+      Hist_init(&latency[op]);
+#  endif
+   for (q = 0; q < thread_count; q++) {
+      member_total += stats[q].count[MEMBER_OP];
+      insert_total += stats[q].count[INSERT_OP];
+      delete_total += stats[q].count[DELETE_OP];
+#     ifdef LATENCY
+      for (op = 0; op < OP_TYPES; op++)
+         Hist_merge(&latency[op], &stats[q].latency[op]);
+#     endif
+   }
+}  /* Merge_stats */
\ No newline at end of file
@@ -5,8 +5,8 @@
  *           This version uses a single mutex
  * 
  * Compile:  gcc -g -Wall -o pth_linked_list_one_mut pth_linked_list_one_mut.c 
- *              my_rand.c -lpthread
- * Usage:    ./pth_linked_list_one_mut <thread_count>
+ *              my_rand.c workload.c -lpthread -lm
+ * Usage:    ./pth_linked_list_one_mut <thread_count> [key distribution]
  * Input:    total number of keys inserted by main thread
  *           total number of ops carried out 
  *           percent of ops that are searches and inserts (remaining ops
@@ -22,11 +22,42 @@
  *        uses a simple linear congruential generator.
  *    5.  -DOUTPUT flag to gcc will show list before and after
  *        threads have worked on it.
+ *    6.  Compile with -DNODE_POOL, and add node_pool.c to the command
+ *        line, to allocate list nodes from the per-thread pools in
+ *        node_pool.c instead of calling malloc and free.
+ *    7.  The optional second argument selects the distribution of the
+ *        keys used by the threads (see workload.c):  u (uniform, the
+ *        default), z[theta] (Zipfian), s (sequential), or h[f,p] (hot
+ *        set).  The keys inserted by the main thread are uniform.
+ *    8.  Each thread keeps its op counts in its own cache-line-aligned
+ *        struct, and main adds them up after the threads finish.
+ *    9.  Compile with -DLATENCY, and add histogram.c to the command
+ *        line, to time every op.  Each thread records the times in its
+ *        own histograms (see histogram.c), and the p50, p99 and p99.9
+ *        latencies of each type of op are printed at the end.
+ *   10.  Compile with -DBLOOM, and add bloom.c to the command line, to
+ *        keep a counting Bloom filter of the keys in the list (see
+ *        bloom.c).  A thread checks the filter before it reads the
+ *        list for Member, and if the key is definitely not in the
+ *        list, Member isn't called.  Insert adds the key to the filter
+ *        before it links the new node, and Delete removes it after the
+ *        node is unlinked, so the filter never misses a key that's in
+ *        the list.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include "my_rand.h"
+#include "workload.h"
+#ifdef LATENCY
+#include "histogram.h"
+#endif
+#ifdef NODE_POOL
+#include "node_pool.h"
+#endif
+#ifdef BLOOM
+#include "bloom.h"
+#endif
 #include "timer.h"
 
 /* Random ints are less than MAX_KEY */
@@ -38,6 +69,20 @@ struct list_node_s {
    struct list_node_s* next;
 };
 
+#define CACHE_LINE 64
+#define MEMBER_OP 0
+#define INSERT_OP 1
+#define DELETE_OP 2
+#define OP_TYPES 3
+
+/* Per-thread statistics, padded to a multiple of the cache line size */
+struct stats_s {
+   int    count[OP_TYPES];
+#  ifdef LATENCY
+   struct histogram_s latency[OP_TYPES];
+#  endif
+} __attribute__((aligned(CACHE_LINE)));
+
 /* Shared variables */
 struct      list_node_s* head = NULL;  
 int         thread_count;
@@ -46,47 +91,74 @@ double      insert_percent;
 double      search_percent;
 double      delete_percent;
 pthread_mutex_t mutex;
-pthread_mutex_t count_mutex;
+struct      stats_s* stats;
+#ifdef BLOOM
+struct      bloom_s* bloom;
+#endif
+#ifdef LATENCY
+struct      histogram_s latency[OP_TYPES];
+#endif
 int         member_total=0, insert_total=0, delete_total=0;
 
 /* Setup and cleanup */
 void        Usage(char* prog_name);
 void        Get_input(int* inserts_in_main_p);
+void        Merge_stats(void);
 
 /* Thread function */
 void*       Thread_work(void* rank);
 
 /* List operations */
 int         Insert(int value);
+int         Insert_batch(int values[], int n);
+int         Compare(const void* x_p, const void* y_p);
 void        Print(void);
 int         Member(int value);
+int         Maybe_member(int value);
 int         Delete(int value);
 void        Free_list(void);
+struct list_node_s* Allocate_node(void);
+void        Free_node(struct list_node_s* node);
 int         Is_empty(void);
 
 /*-----------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
    long i; 
-   int key, success, attempts;
+   int j, batch, attempts;
+   int* keys;
    pthread_t* thread_handles;
    int inserts_in_main;
    unsigned seed = 1;
    double start, finish;
 
-   if (argc != 2) Usage(argv[0]);
+   if (argc != 2 && argc != 3) Usage(argv[0]);
    thread_count = strtol(argv[1],NULL,10);
+   if (!Workload_init(argc == 3 ? argv[2] : "u", MAX_KEY, thread_count))
+      Usage(argv[0]);
 
    Get_input(&inserts_in_main);
+#  ifdef BLOOM
+   bloom = Bloom_init(inserts_in_main + insert_percent*total_ops);
+#  endif
+#  ifdef NODE_POOL
+   Pool_init(sizeof(struct list_node_s));
+#  endif
 
    /* Try to insert inserts_in_main keys, but give up after */
-   /* 2*inserts_in_main attempts.                           */
+   /* 2*inserts_in_main attempts.  The keys are generated   */
+   /* in batches, and each batch is inserted in one pass.   */
+   keys = malloc(inserts_in_main*sizeof(int));
    i = attempts = 0;
    while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
-      key = my_rand(&seed) % MAX_KEY;
-      success = Insert(key);
-      attempts++;
-      if (success) i++;
+      batch = inserts_in_main - i;
+      if (batch > 2*inserts_in_main - attempts)
+         batch = 2*inserts_in_main - attempts;
+      for (j = 0; j < batch; j++)
+         keys[j] = my_rand(&seed) % MAX_KEY;
+      i += Insert_batch(keys, batch);
+      attempts += batch;
    }
+   free(keys);
    printf("Inserted %ld keys in empty list\n", i);
 
 #  ifdef OUTPUT
@@ -97,7 +169,7 @@ int main(int argc, char* argv[]) {
 
    thread_handles = malloc(thread_count*sizeof(pthread_t));
    pthread_mutex_init(&mutex, NULL);
-   pthread_mutex_init(&count_mutex, NULL);
+   stats = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct stats_s));
 
    GET_TIME(start);
    for (i = 0; i < thread_count; i++)
@@ -106,11 +178,17 @@ int main(int argc, char* argv[]) {
    for (i = 0; i < thread_count; i++)
       pthread_join(thread_handles[i], NULL);
    GET_TIME(finish);
+   Merge_stats();
    printf("Elapsed time = %e seconds\n", finish - start);
    printf("Total ops = %d\n", total_ops);
    printf("member ops = %d\n", member_total);
    printf("insert ops = %d\n", insert_total);
    printf("delete ops = %d\n", delete_total);
+#  ifdef LATENCY
+   Hist_print("member", &latency[MEMBER_OP]);
+   Hist_print("insert", &latency[INSERT_OP]);
+   Hist_print("delete", &latency[DELETE_OP]);
+#  endif
 
 #  ifdef OUTPUT
    printf("After threads terminate, list = \n");
@@ -119,9 +197,15 @@ int main(int argc, char* argv[]) {
 #  endif
 
    Free_list();
+#  ifdef BLOOM
+   Bloom_destroy(bloom);
+#  endif
    pthread_mutex_destroy(&mutex);
-   pthread_mutex_destroy(&count_mutex);
+   free(stats);
    free(thread_handles);
+#  ifdef NODE_POOL
+   Pool_destroy();
+#  endif
 
    return 0;
 }  /* main */
@@ -129,7 +213,9 @@ int main(int argc, char* argv[]) {
 
 /*-----------------------------------------------------------------*/
 void Usage(char* prog_name) {
-   fprintf(stderr, "usage: %s <thread_count>\n", prog_name);
+   fprintf(stderr, "usage: %s <thread_count> [key distribution]\n",
+         prog_name);
+   fprintf(stderr, "   key distribution:  u, z[theta], s, or h[f,p]\n");
    exit(0);
 }  /* Usage */
 
@@ -162,7 +248,10 @@ int Insert(int value) {
    }
 
    if (curr == NULL || curr->data > value) {
-      temp = malloc(sizeof(struct list_node_s));
+#     ifdef BLOOM
+      Bloom_add(bloom, value);
+#     endif
+      temp = Allocate_node();
       temp->data = value;
       temp->next = curr;
       if (pred == NULL)
@@ -176,6 +265,55 @@ int Insert(int value) {
    return rv;
 }  /* Insert */
 
+/*-----------------------------------------------------------------*/
+/* Insert the n values in values[] into the list in a single pass */
+/* values[] is sorted in place.  Return number of values inserted */
+int Insert_batch(int values[], int n) {
+   struct list_node_s* curr = head;
+   struct list_node_s* pred = NULL;
+   struct list_node_s* temp;
+   int i, count = 0;
+
+   qsort(values, n, sizeof(int), Compare);
+   for (i = 0; i < n; i++) {
+      if (i > 0 && values[i] == values[i-1]) continue;
+      while (curr != NULL && curr->data < values[i]) {
+         pred = curr;
+         curr = curr->next;
+      }
+      if (curr == NULL || curr->data > values[i]) {
+#        ifdef BLOOM
+         Bloom_add(bloom, values[i]);
+#        endif
+         temp = Allocate_node();
+         temp->data = values[i];
+         temp->next = curr;
+         if (pred == NULL)
+            head = temp;
+         else
+            pred->next = temp;
+         pred = temp;
+         count++;
+      }
+   }
+
+   return count;
+}  /* Insert_batch */
+
+/*-----------------------------------------------------------------*/
+/* Compare two ints, for use by qsort */
+int Compare(const void* x_p, const void* y_p) {
+   int x = *((int*)x_p);
+   int y = *((int*)y_p);
+
+   if (x < y)
+      return -1;
+   else if (x == y)
+      return 0;
+   else /* x > y */
+      return 1;
+}  /* Compare */
+
 /*-----------------------------------------------------------------*/
 void Print(void) {
    struct list_node_s* temp;
@@ -212,6 +350,16 @@ int  Member(int value) {
    }
 }  /* Member */
 
+/*-----------------------------------------------------------------*/
+/* Return 0 if value is definitely not in the list, 1 if it may be */
+int Maybe_member(int value) {
+#  ifdef BLOOM
+   return Bloom_maybe(bloom, value);
+#  else
+   return 1;
+#  endif
+}  /* Maybe_member */
+
 /*-----------------------------------------------------------------*/
 /* Deletes value from list */
 /* If value is in list, return 1, else return 0 */
@@ -232,14 +380,17 @@ int Delete(int value) {
 #        ifdef DEBUG
          printf("Freeing %d\n", value);
 #        endif
-         free(curr);
+         Free_node(curr);
       } else { 
          pred->next = curr->next;
 #        ifdef DEBUG
          printf("Freeing %d\n", value);
 #        endif
-         free(curr);
+         Free_node(curr);
       }
+#     ifdef BLOOM
+      Bloom_remove(bloom, value);
+#     endif
    } else { /* Not in list */
       rv = 0;
    }
@@ -247,6 +398,26 @@ int Delete(int value) {
    return rv;
 }  /* Delete */
 
+/*-----------------------------------------------------------------*/
+/* Get storage for a list node from the node pool or malloc */
+struct list_node_s* Allocate_node(void) {
+#  ifdef NODE_POOL
+   return Pool_alloc();
+#  else
+   return malloc(sizeof(struct list_node_s));
+#  endif
+}  /* Allocate_node */
+
+/*-----------------------------------------------------------------*/
+/* Return storage for a list node to the node pool or free it */
+void Free_node(struct list_node_s* node) {
+#  ifdef NODE_POOL
+   Pool_free(node);
+#  else
+   free(node);
+#  endif
+}  /* Free_node */
+
 /*-----------------------------------------------------------------*/
 void Free_list(void) {
    struct list_node_s* current;
@@ -259,14 +430,14 @@ void Free_list(void) {
 #     ifdef DEBUG
       printf("Freeing %d\n", current->data);
 #     endif
-      free(current);
+      Free_node(current);
       current = following;
       following = current->next;
    }
 #  ifdef DEBUG
    printf("Freeing %d\n", current->data);
 #  endif
-   free(current);
+   Free_node(current);
 }  /* Free_list */
 
 /*-----------------------------------------------------------------*/
@@ -283,35 +454,71 @@ void* Thread_work(void* rank) {
    int i, val;
    double which_op;
    unsigned seed = my_rank + 1;
-   int my_member=0, my_insert=0, my_delete=0;
+   struct stats_s* my_stats = &stats[my_rank];
+   int op;
+#  ifdef LATENCY
+   unsigned long op_start;
+#  endif
    int ops_per_thread = total_ops/thread_count;
 
+   for (op = 0; op < OP_TYPES; op++) {
+      my_stats->count[op] = 0;
+#     ifdef LATENCY
+      Hist_init(&my_stats->latency[op]);
+#     endif
+   }
+
+   Workload_start(my_rank);
    for (i = 0; i < ops_per_thread; i++) {
       which_op = my_drand(&seed);
-      val = my_rand(&seed) % MAX_KEY;
+      val = Workload_key(&seed);
+#     ifdef LATENCY
+      op_start = Hist_now();
+#     endif
       if (which_op < search_percent) {
-         pthread_mutex_lock(&mutex);
-         Member(val);
-         pthread_mutex_unlock(&mutex);
-         my_member++;
+         if (Maybe_member(val)) {
+            pthread_mutex_lock(&mutex);
+            Member(val);
+            pthread_mutex_unlock(&mutex);
+         }
+         op = MEMBER_OP;
       } else if (which_op < search_percent + insert_percent) {
          pthread_mutex_lock(&mutex);
          Insert(val);
          pthread_mutex_unlock(&mutex);
-         my_insert++;
+         op = INSERT_OP;
       } else { /* delete */
          pthread_mutex_lock(&mutex);
          Delete(val);
          pthread_mutex_unlock(&mutex);
-         my_delete++;
+         op = DELETE_OP;
       }
+#     ifdef LATENCY
+      Hist_record(&my_stats->latency[op], Hist_now() - op_start);
+#     endif
+      my_stats->count[op]++;
    }  /* for */
 
-   pthread_mutex_lock(&count_mutex);
-   member_total += my_member;
-   insert_total += my_insert;
-   delete_total += my_delete;
-   pthread_mutex_unlock(&count_mutex);
-
    return NULL;
-}  /* Thread_work */
\ No newline at end of file
+}  /* Thread_work */
+
+/*-----------------------------------------------------------------*/
+/* Add up the threads' op counts, and merge their latency histograms */
+void Merge_stats(void) {
+   int q;
+#  ifdef LATENCY
+   int op;
+
+   for (op = 0; op < OP_TYPES; op++)
+      Hist_init(&latency[op]);
+#  endif
+   for (q = 0; q < thread_count; q++) {
+      member_total += stats[q].count[MEMBER_OP];
+      insert_total += stats[q].count[INSERT_OP];
+      delete_total += stats[q].count[DELETE_OP];
+#     ifdef LATENCY
+      for (op = 0; op < OP_TYPES; op++)
+         Hist_merge(&latency[op], &stats[q].latency[op]);
+#     endif
+   }
+}  /* Merge_stats */
\ No newline at end of file
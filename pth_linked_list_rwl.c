@@ -5,8 +5,12 @@
  *           This version uses read-write locks
  * 
  * Compile:  gcc -g -Wall -o pth_linked_list_rwl pth_linked_list_rwl.c 
- *              my_rand.c -lpthread
- * Usage:    ./pth_linked_list_rwl <thread_count>
+ *              my_rand.c br_rwlock.c epoch.c workload.c -lpthread -lm
+ * Usage:    ./pth_linked_list_rwl <thread_count> [lock type]
+ *              [key distribution]
+ *           lock type:  p = Pthreads rwlock (default),
+ *                       b = big-reader rwlock from br_rwlock.c,
+ *                       c = RCU-style:  readers don't lock
  * Input:    total number of keys inserted by main thread
  *           total number of ops 
  *           percent of ops that are search, insert (remainder are delete)
@@ -20,11 +24,70 @@
  *        uses a simple linear congruential generator.
  *    4.  -DOUTPUT flag to gcc will show list before and after
  *        threads have worked on it.
+ *    5.  Compile with -DNODE_POOL, and add node_pool.c to the command
+ *        line, to allocate list nodes from the per-thread pools in
+ *        node_pool.c instead of calling malloc and free.
+ *    6.  With the Pthreads rwlock every reader writes to the lock's
+ *        shared cache line.  The big-reader lock gives each thread
+ *        its own padded reader flag, so readers don't interfere with
+ *        each other, but a writer has to check every thread's flag.
+ *        Writers have preference, so they can't be starved by readers.
+ *    7.  With lock type c, Member doesn't acquire any lock:  it only
+ *        marks itself as a reader with Epoch_enter (see epoch.c).
+ *        Writers are serialized by a mutex.  Insert initializes the
+ *        new node completely before it's linked in, and both Insert
+ *        and Delete change the list with a single atomic pointer
+ *        store, so a reader sees either the old list or the new one.
+ *        Deleted nodes are passed to Epoch_retire, and they're freed
+ *        when no reader can still be looking at them.
+ *    8.  The optional third argument selects the distribution of the
+ *        keys used by the threads (see workload.c):  u (uniform, the
+ *        default), z[theta] (Zipfian), s (sequential), or h[f,p] (hot
+ *        set).  The keys inserted by the main thread are uniform.
+ *    9.  Each thread keeps its op counts in its own cache-line-aligned
+ *        struct, and main adds them up after the threads finish.
+ *   10.  Compile with -DLATENCY, and add histogram.c to the command
+ *        line, to time every op.  Each thread records the times in its
+ *        own histograms (see histogram.c), and the p50, p99 and p99.9
+ *        latencies of each type of op are printed at the end.
+ *   11.  Compile with -DBLOOM, and add bloom.c to the command line, to
+ *        keep a counting Bloom filter of the keys in the list (see
+ *        bloom.c).  A thread checks the filter before it reads the
+ *        list for Member, and if the key is definitely not in the
+ *        list, Member isn't called.  Insert adds the key to the filter
+ *        before it links the new node, and Delete removes it after the
+ *        node is unlinked, so the filter never misses a key that's in
+ *        the list.
+ *   12.  Compile with -DCOMPACT to compact the list.  After many
+ *        inserts and deletes the nodes are scattered through the
+ *        heap.  When the nodes that aren't in the arena, plus the
+ *        holes left in the arena by deleted nodes, are more than
+ *        COMPACT_PERCENT percent of the list, the thread that holds the
+ *        write lock calls Compact, which copies the nodes in key order
+ *        into a new array (the arena) and frees the old ones.  Readers
+ *        can't be in the list, since the writer holds the lock.  Nodes
+ *        in the arena are only counted when they're deleted, and the
+ *        whole arena is freed by the next Compact.  Compaction isn't
+ *        used with lock type c, since readers don't take the lock.
+ *        The copying is done inside the timed region, so times with
+ *        and without -DCOMPACT aren't directly comparable.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include "my_rand.h"
+#include "workload.h"
+#ifdef LATENCY
+#include "histogram.h"
+#endif
+#include "br_rwlock.h"
+#include "epoch.h"
+#ifdef NODE_POOL
+#include "node_pool.h"
+#endif
+#ifdef BLOOM
+#include "bloom.h"
+#endif
 #include "timer.h"
 
 /* Random ints are less than MAX_KEY */
@@ -37,6 +100,33 @@ struct list_node_s {
    struct list_node_s* next;
 };
 
+#define CACHE_LINE 64
+#define MEMBER_OP 0
+#define INSERT_OP 1
+#define DELETE_OP 2
+#define OP_TYPES 3
+#ifdef COMPACT
+#define COMPACT_MIN 1024     /* Don't compact shorter lists */
+#define COMPACT_PERCENT 25
+#endif
+
+/* Per-thread statistics, padded to a multiple of the cache line size */
+struct stats_s {
+   int    count[OP_TYPES];
+#  ifdef LATENCY
+   struct histogram_s latency[OP_TYPES];
+#  endif
+} __attribute__((aligned(CACHE_LINE)));
+
+#ifdef COMPACT
+/* Array of nodes in key order built by Compact */
+struct arena_s {
+   struct list_node_s* nodes;
+   int    size;        /* Number of nodes in the array */
+   int    live;        /* Number of them that are still in the list */
+};
+#endif
+
 /* Shared variables */
 struct      list_node_s* head = NULL;  
 int         thread_count;
@@ -44,48 +134,104 @@ int         total_ops;
 double      insert_percent;
 double      search_percent;
 double      delete_percent;
+char        lock_type = 'p';
 pthread_rwlock_t    rwlock;
-pthread_mutex_t     count_mutex;
+struct      br_rwlock_s* br_lock;
+pthread_mutex_t     write_mutex;
+struct      stats_s* stats;
+#ifdef BLOOM
+struct      bloom_s* bloom;
+#endif
+#ifdef LATENCY
+struct      histogram_s latency[OP_TYPES];
+#endif
 int         member_count = 0, insert_count = 0, delete_count = 0;
+#ifdef COMPACT
+/* Protected by the write lock */
+struct      arena_s arena = {NULL, 0, 0};
+int         list_size = 0;
+int         compact = 1;
+int         compactions = 0;
+#endif
 
 /* Setup and cleanup */
 void        Usage(char* prog_name);
 void        Get_input(int* inserts_in_main_p);
+void        Merge_stats(void);
 
 /* Thread function */
 void*       Thread_work(void* rank);
 
+/* Lock operations */
+void        Read_lock(long my_rank);
+void        Read_unlock(long my_rank);
+void        Write_lock(void);
+void        Write_unlock(void);
+
 /* List operations */
 int         Insert(int value);
+int         Insert_batch(int values[], int n);
+int         Compare(const void* x_p, const void* y_p);
 void        Print(void);
 int         Member(int value);
+int         Maybe_member(int value);
 int         Delete(int value);
 void        Free_list(void);
+struct list_node_s* Allocate_node(void);
+void        Free_node(struct list_node_s* node);
+void        Free_retired(void* node);
+void        Retire_node(struct list_node_s* node);
+#ifdef COMPACT
+int         In_arena(struct list_node_s* node);
+void        Maybe_compact(void);
+void        Compact(void);
+#endif
 int         Is_empty(void);
 
 /*-----------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
    long i; 
-   int key, success, attempts;
+   int j, batch, attempts;
+   int* keys;
    pthread_t* thread_handles;
    int inserts_in_main;
    unsigned seed = 1;
    double start, finish;
 
-   if (argc != 2) Usage(argv[0]);
+   if (argc < 2 || argc > 4) Usage(argv[0]);
    thread_count = strtol(argv[1],NULL,10);
+   if (argc >= 3) lock_type = argv[2][0];
+   if (lock_type != 'p' && lock_type != 'b' && lock_type != 'c')
+      Usage(argv[0]);
+#  ifdef COMPACT
+   compact = (lock_type != 'c');
+#  endif
+   if (!Workload_init(argc == 4 ? argv[3] : "u", MAX_KEY, thread_count))
+      Usage(argv[0]);
 
    Get_input(&inserts_in_main);
+#  ifdef BLOOM
+   bloom = Bloom_init(inserts_in_main + insert_percent*total_ops);
+#  endif
+#  ifdef NODE_POOL
+   Pool_init(sizeof(struct list_node_s));
+#  endif
 
    /* Try to insert inserts_in_main keys, but give up after */
-   /* 2*inserts_in_main attempts.                           */
+   /* 2*inserts_in_main attempts.  The keys are generated   */
+   /* in batches, and each batch is inserted in one pass.   */
+   keys = malloc(inserts_in_main*sizeof(int));
    i = attempts = 0;
    while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
-      key = my_rand(&seed) % MAX_KEY;
-      success = Insert(key);
-      attempts++;
-      if (success) i++;
+      batch = inserts_in_main - i;
+      if (batch > 2*inserts_in_main - attempts)
+         batch = 2*inserts_in_main - attempts;
+      for (j = 0; j < batch; j++)
+         keys[j] = my_rand(&seed) % MAX_KEY;
+      i += Insert_batch(keys, batch);
+      attempts += batch;
    }
+   free(keys);
    printf("Inserted %ld keys in empty list\n", i);
 
 #  ifdef OUTPUT
@@ -95,8 +241,16 @@ int main(int argc, char* argv[]) {
 #  endif
 
    thread_handles = malloc(thread_count*sizeof(pthread_t));
-   pthread_mutex_init(&count_mutex, NULL);
-   pthread_rwlock_init(&rwlock, NULL);
+   stats = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct stats_s));
+   if (lock_type == 'b') {
+      br_lock = Br_init(thread_count);
+   } else if (lock_type == 'c') {
+      pthread_mutex_init(&write_mutex, NULL);
+      Epoch_init(thread_count, Free_retired);
+      Epoch_register(thread_count);
+   } else {
+      pthread_rwlock_init(&rwlock, NULL);
+   }
 
    GET_TIME(start);
    for (i = 0; i < thread_count; i++)
@@ -105,11 +259,20 @@ int main(int argc, char* argv[]) {
    for (i = 0; i < thread_count; i++)
       pthread_join(thread_handles[i], NULL);
    GET_TIME(finish);
+   Merge_stats();
    printf("Elapsed time = %e seconds\n", finish - start);
    printf("Total ops = %d\n", total_ops);
    printf("member ops = %d\n", member_count);
    printf("insert ops = %d\n", insert_count);
    printf("delete ops = %d\n", delete_count);
+#  ifdef COMPACT
+   if (compact) printf("compactions = %d\n", compactions);
+#  endif
+#  ifdef LATENCY
+   Hist_print("member", &latency[MEMBER_OP]);
+   Hist_print("insert", &latency[INSERT_OP]);
+   Hist_print("delete", &latency[DELETE_OP]);
+#  endif
 
 #  ifdef OUTPUT
    printf("After threads terminate, list = \n");
@@ -118,9 +281,22 @@ int main(int argc, char* argv[]) {
 #  endif
 
    Free_list();
-   pthread_rwlock_destroy(&rwlock);
-   pthread_mutex_destroy(&count_mutex);
+#  ifdef BLOOM
+   Bloom_destroy(bloom);
+#  endif
+   if (lock_type == 'b') {
+      Br_destroy(br_lock);
+   } else if (lock_type == 'c') {
+      Epoch_destroy();
+      pthread_mutex_destroy(&write_mutex);
+   } else {
+      pthread_rwlock_destroy(&rwlock);
+   }
+   free(stats);
    free(thread_handles);
+#  ifdef NODE_POOL
+   Pool_destroy();
+#  endif
 
    return 0;
 }  /* main */
@@ -128,7 +304,12 @@ int main(int argc, char* argv[]) {
 
 /*-----------------------------------------------------------------*/
 void Usage(char* prog_name) {
-   fprintf(stderr, "usage: %s <thread_count>\n", prog_name);
+   fprintf(stderr, "usage: %s <thread_count> [lock type] [key distribution]\n",
+         prog_name);
+   fprintf(stderr, "   lock type:  p = Pthreads rwlock (default)\n");
+   fprintf(stderr, "               b = big-reader rwlock\n");
+   fprintf(stderr, "               c = RCU-style, lock-free readers\n");
+   fprintf(stderr, "   key distribution:  u, z[theta], s, or h[f,p]\n");
    exit(0);
 }  /* Usage */
 
@@ -161,13 +342,17 @@ int Insert(int value) {
    }
 
    if (curr == NULL || curr->data > value) {
-      temp = malloc(sizeof(struct list_node_s));
+#     ifdef BLOOM
+      Bloom_add(bloom, value);
+#     endif
+      temp = Allocate_node();
       temp->data = value;
       temp->next = curr;
+      /* Publish the initialized node */
       if (pred == NULL)
-         head = temp;
+         __atomic_store_n(&head, temp, __ATOMIC_RELEASE);
       else
-         pred->next = temp;
+         __atomic_store_n(&pred->next, temp, __ATOMIC_RELEASE);
    } else { /* value in list */
       rv = 0;
    }
@@ -175,6 +360,55 @@ int Insert(int value) {
    return rv;
 }  /* Insert */
 
+/*-----------------------------------------------------------------*/
+/* Insert the n values in values[] into the list in a single pass */
+/* values[] is sorted in place.  Return number of values inserted */
+int Insert_batch(int values[], int n) {
+   struct list_node_s* curr = head;
+   struct list_node_s* pred = NULL;
+   struct list_node_s* temp;
+   int i, count = 0;
+
+   qsort(values, n, sizeof(int), Compare);
+   for (i = 0; i < n; i++) {
+      if (i > 0 && values[i] == values[i-1]) continue;
+      while (curr != NULL && curr->data < values[i]) {
+         pred = curr;
+         curr = curr->next;
+      }
+      if (curr == NULL || curr->data > values[i]) {
+#        ifdef BLOOM
+         Bloom_add(bloom, values[i]);
+#        endif
+         temp = Allocate_node();
+         temp->data = values[i];
+         temp->next = curr;
+         if (pred == NULL)
+            head = temp;
+         else
+            pred->next = temp;
+         pred = temp;
+         count++;
+      }
+   }
+
+   return count;
+}  /* Insert_batch */
+
+/*-----------------------------------------------------------------*/
+/* Compare two ints, for use by qsort */
+int Compare(const void* x_p, const void* y_p) {
+   int x = *((int*)x_p);
+   int y = *((int*)y_p);
+
+   if (x < y)
+      return -1;
+   else if (x == y)
+      return 0;
+   else /* x > y */
+      return 1;
+}  /* Compare */
+
 /*-----------------------------------------------------------------*/
 void Print(void) {
    struct list_node_s* temp;
@@ -194,9 +428,9 @@ void Print(void) {
 int  Member(int value) {
    struct list_node_s* temp;
 
-   temp = head;
+   temp = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
    while (temp != NULL && temp->data < value)
-      temp = temp->next;
+      temp = __atomic_load_n(&temp->next, __ATOMIC_ACQUIRE);
 
    if (temp == NULL || temp->data > value) {
 #     ifdef DEBUG
@@ -211,6 +445,16 @@ int  Member(int value) {
    }
 }  /* Member */
 
+/*-----------------------------------------------------------------*/
+/* Return 0 if value is definitely not in the list, 1 if it may be */
+int Maybe_member(int value) {
+#  ifdef BLOOM
+   return Bloom_maybe(bloom, value);
+#  else
+   return 1;
+#  endif
+}  /* Maybe_member */
+
 /*-----------------------------------------------------------------*/
 /* Deletes value from list */
 /* If value is in list, return 1, else return 0 */
@@ -227,18 +471,21 @@ int Delete(int value) {
    
    if (curr != NULL && curr->data == value) {
       if (pred == NULL) { /* first element in list */
-         head = curr->next;
+         __atomic_store_n(&head, curr->next, __ATOMIC_RELEASE);
 #        ifdef DEBUG
          printf("Freeing %d\n", value);
 #        endif
-         free(curr);
+         Retire_node(curr);
       } else { 
-         pred->next = curr->next;
+         __atomic_store_n(&pred->next, curr->next, __ATOMIC_RELEASE);
 #        ifdef DEBUG
          printf("Freeing %d\n", value);
 #        endif
-         free(curr);
+         Retire_node(curr);
       }
+#     ifdef BLOOM
+      Bloom_remove(bloom, value);
+#     endif
    } else { /* Not in list */
       rv = 0;
    }
@@ -246,26 +493,132 @@ int Delete(int value) {
    return rv;
 }  /* Delete */
 
+/*-----------------------------------------------------------------*/
+/* Get storage for a list node from the node pool or malloc */
+struct list_node_s* Allocate_node(void) {
+#  ifdef COMPACT
+   if (compact) list_size++;
+#  endif
+#  ifdef NODE_POOL
+   return Pool_alloc();
+#  else
+   return malloc(sizeof(struct list_node_s));
+#  endif
+}  /* Allocate_node */
+
+/*-----------------------------------------------------------------*/
+/* Return storage for a list node to the node pool or free it */
+/* Nodes in the arena are just counted                          */
+void Free_node(struct list_node_s* node) {
+#  ifdef COMPACT
+   if (compact) {
+      list_size--;
+      if (In_arena(node)) {
+         arena.live--;
+         return;
+      }
+   }
+#  endif
+#  ifdef NODE_POOL
+   Pool_free(node);
+#  else
+   free(node);
+#  endif
+}  /* Free_node */
+
+/*-----------------------------------------------------------------*/
+/* Free a node passed to Epoch_retire, once no reader can see it */
+void Free_retired(void* node) {
+   Free_node(node);
+}  /* Free_retired */
+
+/*-----------------------------------------------------------------*/
+/* Free a node that has just been unlinked from the list.  If      */
+/* readers don't lock, they may still be using it, so retire it.   */
+void Retire_node(struct list_node_s* node) {
+   if (lock_type == 'c')
+      Epoch_retire(node);
+   else
+      Free_node(node);
+}  /* Retire_node */
+
+#ifdef COMPACT
+/*-----------------------------------------------------------------*/
+/* Return 1 if node is in the arena, 0 if it was allocated by      */
+/* Allocate_node                                                    */
+int In_arena(struct list_node_s* node) {
+   return node >= arena.nodes && node < arena.nodes + arena.size;
+}  /* In_arena */
+
+/*-----------------------------------------------------------------*/
+/* Compact the list if the nodes outside the arena plus the holes  */
+/* in the arena are more than COMPACT_PERCENT percent of the list  */
+/* The caller must hold the write lock                              */
+void Maybe_compact(void) {
+   long out_of_place;
+
+   if (!compact || list_size < COMPACT_MIN) return;
+   out_of_place = (list_size - arena.live) + (arena.size - arena.live);
+   if (100*out_of_place > (long) COMPACT_PERCENT*list_size)
+      Compact();
+}  /* Maybe_compact */
+
+/*-----------------------------------------------------------------*/
+/* Copy the nodes into a new arena in key order, and free the old  */
+/* nodes and the old arena.  The caller must hold the write lock   */
+void Compact(void) {
+   struct list_node_s* nodes;
+   struct list_node_s* curr = head;
+   struct list_node_s* following;
+   int i = 0;
+
+   nodes = (list_size > 0) ?
+      malloc(list_size*sizeof(struct list_node_s)) : NULL;
+   while (curr != NULL) {
+      following = curr->next;
+      nodes[i].data = curr->data;
+      nodes[i].next = (following != NULL) ? &nodes[i+1] : NULL;
+      Free_node(curr);
+      curr = following;
+      i++;
+   }
+   free(arena.nodes);
+
+   arena.nodes = nodes;
+   arena.size = arena.live = list_size = i;
+   head = nodes;
+   compactions++;
+}  /* Compact */
+#endif
+
 /*-----------------------------------------------------------------*/
 void Free_list(void) {
    struct list_node_s* current;
    struct list_node_s* following;
 
-   if (Is_empty()) return;
+   if (Is_empty()) {
+#     ifdef COMPACT
+      free(arena.nodes);
+#     endif
+      return;
+   }
    current = head; 
    following = current->next;
    while (following != NULL) {
 #     ifdef DEBUG
       printf("Freeing %d\n", current->data);
 #     endif
-      free(current);
+      Free_node(current);
       current = following;
       following = current->next;
    }
 #  ifdef DEBUG
    printf("Freeing %d\n", current->data);
 #  endif
-   free(current);
+   Free_node(current);
+#  ifdef COMPACT
+   free(arena.nodes);
+#  endif
 }  /* Free_list */
 
 /*-----------------------------------------------------------------*/
@@ -282,35 +635,120 @@ void* Thread_work(void* rank) {
    int i, val;
    double which_op;
    unsigned seed = my_rank + 1;
-   int my_member_count = 0, my_insert_count=0, my_delete_count=0;
+   struct stats_s* my_stats = &stats[my_rank];
+   int op;
+#  ifdef LATENCY
+   unsigned long op_start;
+#  endif
    int ops_per_thread = total_ops/thread_count;
 
+   for (op = 0; op < OP_TYPES; op++) {
+      my_stats->count[op] = 0;
+#     ifdef LATENCY
+      Hist_init(&my_stats->latency[op]);
+#     endif
+   }
+
+   Workload_start(my_rank);
+   if (lock_type == 'c') Epoch_register(my_rank);
    for (i = 0; i < ops_per_thread; i++) {
       which_op = my_drand(&seed);
-      val = my_rand(&seed) % MAX_KEY;
+      val = Workload_key(&seed);
+#     ifdef LATENCY
+      op_start = Hist_now();
+#     endif
       if (which_op < search_percent) {
-         pthread_rwlock_rdlock(&rwlock);
-         Member(val);
-         pthread_rwlock_unlock(&rwlock);
-         my_member_count++;
+         if (Maybe_member(val)) {
+            Read_lock(my_rank);
+            Member(val);
+            Read_unlock(my_rank);
+         }
+         op = MEMBER_OP;
       } else if (which_op < search_percent + insert_percent) {
-         pthread_rwlock_wrlock(&rwlock);
+         Write_lock();
          Insert(val);
-         pthread_rwlock_unlock(&rwlock);
-         my_insert_count++;
+#        ifdef COMPACT
+         Maybe_compact();
+#        endif
+         Write_unlock();
+         op = INSERT_OP;
       } else { /* delete */
-         pthread_rwlock_wrlock(&rwlock);
+         Write_lock();
          Delete(val);
-         pthread_rwlock_unlock(&rwlock);
-         my_delete_count++;
+#        ifdef COMPACT
+         Maybe_compact();
+#        endif
+         Write_unlock();
+         op = DELETE_OP;
       }
+#     ifdef LATENCY
+      Hist_record(&my_stats->latency[op], Hist_now() - op_start);
+#     endif
+      my_stats->count[op]++;
    }  /* for */
 
-   pthread_mutex_lock(&count_mutex);
-   member_count += my_member_count;
-   insert_count += my_insert_count;
-   delete_count += my_delete_count;
-   pthread_mutex_unlock(&count_mutex);
-
    return NULL;
-}  /* Thread_work */
\ No newline at end of file
+}  /* Thread_work */
+
+/*-----------------------------------------------------------------*/
+/* Add up the threads' op counts, and merge their latency histograms */
+void Merge_stats(void) {
+   int q;
+#  ifdef LATENCY
+   int op;
+
+   for (op = 0; op < OP_TYPES; op++)
+      Hist_init(&latency[op]);
+#  endif
+   for (q = 0; q < thread_count; q++) {
+      member_count += stats[q].count[MEMBER_OP];
+      insert_count += stats[q].count[INSERT_OP];
+      delete_count += stats[q].count[DELETE_OP];
+#     ifdef LATENCY
+      for (op = 0; op < OP_TYPES; op++)
+         Hist_merge(&latency[op], &stats[q].latency[op]);
+#     endif
+   }
+}  /* Merge_stats */
+
+/*-----------------------------------------------------------------*/
+/* Start reading the list.  With lock type c this doesn't lock */
+void Read_lock(long my_rank) {
+   if (lock_type == 'b')
+      Br_rdlock(br_lock, my_rank);
+   else if (lock_type == 'c')
+      Epoch_enter();
+   else
+      pthread_rwlock_rdlock(&rwlock);
+}  /* Read_lock */
+
+/*-----------------------------------------------------------------*/
+void Read_unlock(long my_rank) {
+   if (lock_type == 'b')
+      Br_rdunlock(br_lock, my_rank);
+   else if (lock_type == 'c')
+      Epoch_exit();
+   else
+      pthread_rwlock_unlock(&rwlock);
+}  /* Read_unlock */
+
+/*-----------------------------------------------------------------*/
+/* Acquire the list lock for writing */
+void Write_lock(void) {
+   if (lock_type == 'b')
+      Br_wrlock(br_lock);
+   else if (lock_type == 'c')
+      pthread_mutex_lock(&write_mutex);
+   else
+      pthread_rwlock_wrlock(&rwlock);
+}  /* Write_lock */
+
+/*-----------------------------------------------------------------*/
+void Write_unlock(void) {
+   if (lock_type == 'b')
+      Br_wrunlock(br_lock);
+   else if (lock_type == 'c')
+      pthread_mutex_unlock(&write_mutex);
+   else
+      pthread_rwlock_unlock(&rwlock);
+}  /* Write_unlock */
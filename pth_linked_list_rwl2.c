@@ -20,11 +20,17 @@
  *        uses a simple linear congruential generator.
  *    4.  -DOUTPUT flag to gcc will show list before and after
  *        threads have worked on it.
+ *    5.  Compile with -DNODE_POOL, and add node_pool.c to the command
+ *        line, to allocate list nodes from the per-thread pools in
+ *        node_pool.c instead of calling malloc and free.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include "my_rand.h"
+#ifdef NODE_POOL
+#include "node_pool.h"
+#endif
 #include "timer.h"
 
 /* Random ints are less than MAX_KEY */
@@ -57,16 +63,21 @@ void*       Thread_work(void* rank);
 
 /* List operations */
 int         Insert(int value);
+int         Insert_batch(int values[], int n);
+int         Compare(const void* x_p, const void* y_p);
 void        Print(void);
 int         Member(int value);
 int         Delete(int value);
 void        Free_list(void);
+struct list_node_s* Allocate_node(void);
+void        Free_node(struct list_node_s* node);
 int         Is_empty(void);
 
 /*-----------------------------------------------------------------*/
 int main(int argc, char* argv[]) {
    long i; 
-   int key, success, attempts;
+   int j, batch, attempts;
+   int* keys;
    pthread_t* thread_handles;
    int inserts_in_main;
    unsigned seed = 1;
@@ -76,16 +87,25 @@ int main(int argc, char* argv[]) {
    thread_count = strtol(argv[1],NULL,10);
 
    Get_input(&inserts_in_main);
+#  ifdef NODE_POOL
+   Pool_init(sizeof(struct list_node_s));
+#  endif
 
    /* Try to insert inserts_in_main keys, but give up after */
-   /* 2*inserts_in_main attempts.                           */
+   /* 2*inserts_in_main attempts.  The keys are generated   */
+   /* in batches, and each batch is inserted in one pass.   */
+   keys = malloc(inserts_in_main*sizeof(int));
    i = attempts = 0;
    while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
-      key = my_rand(&seed) % MAX_KEY;
-      success = Insert(key);
-      attempts++;
-      if (success) i++;
+      batch = inserts_in_main - i;
+      if (batch > 2*inserts_in_main - attempts)
+         batch = 2*inserts_in_main - attempts;
+      for (j = 0; j < batch; j++)
+         keys[j] = my_rand(&seed) % MAX_KEY;
+      i += Insert_batch(keys, batch);
+      attempts += batch;
    }
+   free(keys);
    printf("Inserted %ld keys in empty list\n", i);
 
 #  ifdef OUTPUT
@@ -121,6 +141,9 @@ int main(int argc, char* argv[]) {
    pthread_rwlock_destroy(&rwlock);
    pthread_mutex_destroy(&count_mutex);
    free(thread_handles);
+#  ifdef NODE_POOL
+   Pool_destroy();
+#  endif
 
    return 0;
 }  /* main */
@@ -161,7 +184,7 @@ int Insert(int value) {
    }
 
    if (curr == NULL || curr->data > value) {
-      temp = malloc(sizeof(struct list_node_s));
+      temp = Allocate_node();
       temp->data = value;
       temp->next = curr;
       if (pred == NULL)
@@ -175,6 +198,52 @@ int Insert(int value) {
    return rv;
 }  /* Insert */
 
+/*-----------------------------------------------------------------*/
+/* Insert the n values in values[] into the list in a single pass */
+/* values[] is sorted in place.  Return number of values inserted */
+int Insert_batch(int values[], int n) {
+   struct list_node_s* curr = head;
+   struct list_node_s* pred = NULL;
+   struct list_node_s* temp;
+   int i, count = 0;
+
+   qsort(values, n, sizeof(int), Compare);
+   for (i = 0; i < n; i++) {
+      if (i > 0 && values[i] == values[i-1]) continue;
+      while (curr != NULL && curr->data < values[i]) {
+         pred = curr;
+         curr = curr->next;
+      }
+      if (curr == NULL || curr->data > values[i]) {
+         temp = Allocate_node();
+         temp->data = values[i];
+         temp->next = curr;
+         if (pred == NULL)
+            head = temp;
+         else
+            pred->next = temp;
+         pred = temp;
+         count++;
+      }
+   }
+
+   return count;
+}  /* Insert_batch */
+
+/*-----------------------------------------------------------------*/
+/* Compare two ints, for use by qsort */
+int Compare(const void* x_p, const void* y_p) {
+   int x = *((int*)x_p);
+   int y = *((int*)y_p);
+
+   if (x < y)
+      return -1;
+   else if (x == y)
+      return 0;
+   else /* x > y */
+      return 1;
+}  /* Compare */
+
 /*-----------------------------------------------------------------*/
 void Print(void) {
    struct list_node_s* temp;
@@ -231,13 +300,13 @@ int Delete(int value) {
 #        ifdef DEBUG
          printf("Freeing %d\n", value);
 #        endif
-         free(curr);
+         Free_node(curr);
       } else { 
          pred->next = curr->next;
 #        ifdef DEBUG
          printf("Freeing %d\n", value);
 #        endif
-         free(curr);
+         Free_node(curr);
       }
    } else { /* Not in list */
       rv = 0;
@@ -246,6 +315,26 @@ int Delete(int value) {
    return rv;
 }  /* Delete */
 
+/*-----------------------------------------------------------------*/
+/* Get storage for a list node from the node pool or malloc */
+struct list_node_s* Allocate_node(void) {
+#  ifdef NODE_POOL
+   return Pool_alloc();
+#  else
+   return malloc(sizeof(struct list_node_s));
+#  endif
+}  /* Allocate_node */
+
+/*-----------------------------------------------------------------*/
+/* Return storage for a list node to the node pool or free it */
+void Free_node(struct list_node_s* node) {
+#  ifdef NODE_POOL
+   Pool_free(node);
+#  else
+   free(node);
+#  endif
+}  /* Free_node */
+
 /*-----------------------------------------------------------------*/
 void Free_list(void) {
    struct list_node_s* current;
@@ -258,14 +347,14 @@ void Free_list(void) {
 #     ifdef DEBUG
       printf("Freeing %d\n", current->data);
 #     endif
-      free(current);
+      Free_node(current);
       current = following;
       following = current->next;
    }
 #  ifdef DEBUG
    printf("Freeing %d\n", current->data);
 #  endif
-   free(current);
+   Free_node(current);
 }  /* Free_list */
 
 /*-----------------------------------------------------------------*/
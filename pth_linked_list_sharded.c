@@ -0,0 +1,522 @@
+/* File:     pth_linked_list_sharded.c
+ *
+ * Purpose:  Implement a multi-threaded sorted linked list of
+ *           ints with ops insert, print, member, delete, free list.
+ *           This version splits the keys into shard_count ranges
+ *           ("shards").  Each shard is a separate sorted list with
+ *           its own read-write lock.
+ *
+ * Compile:  gcc -g -Wall -o pth_linked_list_sharded
+ *              pth_linked_list_sharded.c my_rand.c workload.c -lpthread -lm
+ * Usage:    ./pth_linked_list_sharded <thread_count> [shard_count]
+ *              [key distribution]
+ * Input:    total number of keys inserted by main thread
+ *           total number of ops
+ *           percent of ops that are search, insert (remainder are delete)
+ * Output:   Elapsed time to carry out the ops
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the list
+ *    2.  DEBUG compile flag used.  To get debug output compile with
+ *        -DDEBUG command line flag.
+ *    3.  The random function is not threadsafe.  So this program
+ *        uses a simple linear congruential generator.
+ *    4.  -DOUTPUT flag to gcc will show list before and after
+ *        threads have worked on it.
+ *    5.  Shard s stores the keys k with
+ *
+ *           s*MAX_KEY/shard_count <= k < (s+1)*MAX_KEY/shard_count
+ *
+ *        So the shards are in increasing order of their keys, and
+ *        Print prints the whole list in order by printing the shards
+ *        one after another.  The default shard_count is 64.
+ *    6.  Each shard (its head pointer and its lock) is on its own
+ *        cache line.  When the keys are uniform, threads are spread
+ *        over the shards' locks instead of all waiting for one lock,
+ *        and each list is about 1/shard_count as long as the
+ *        unsharded list.
+ *    7.  Compile with -DNODE_POOL, and add node_pool.c to the command
+ *        line, to allocate list nodes from the per-thread pools in
+ *        node_pool.c instead of calling malloc and free.
+ *    8.  The optional third argument selects the distribution of the
+ *        keys used by the threads (see workload.c):  u (uniform, the
+ *        default), z[theta] (Zipfian), s (sequential), or h[f,p] (hot
+ *        set).  The keys inserted by the main thread are uniform.
+ *    9.  Compile with -DLATENCY, and add histogram.c to the command
+ *        line, to time every op and print the p50, p99 and p99.9
+ *        latencies of each type of op (see histogram.c).
+ *   10.  Print and Free_list should *not* be called when multiple
+ *        threads are accessing the list.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "my_rand.h"
+#include "workload.h"
+#ifdef LATENCY
+#include "histogram.h"
+#endif
+#ifdef NODE_POOL
+#include "node_pool.h"
+#endif
+#include "timer.h"
+
+/* Random ints are less than MAX_KEY */
+const int MAX_KEY = 100000000;
+
+/* Struct for list nodes */
+struct list_node_s {
+   int    data;
+   struct list_node_s* next;
+};
+
+#define CACHE_LINE 64
+#define MEMBER_OP 0
+#define INSERT_OP 1
+#define DELETE_OP 2
+#define OP_TYPES 3
+
+/* One range of keys:  a sorted list and its lock */
+struct shard_s {
+   struct list_node_s* head;
+   pthread_rwlock_t    rwlock;
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Per-thread statistics, padded to a multiple of the cache line size */
+struct stats_s {
+   int    count[OP_TYPES];
+#  ifdef LATENCY
+   struct histogram_s latency[OP_TYPES];
+#  endif
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Shared variables */
+struct      shard_s* shards;
+int         shard_count = 64;
+int         thread_count;
+int         total_ops;
+double      insert_percent;
+double      search_percent;
+double      delete_percent;
+struct      stats_s* stats;
+#ifdef LATENCY
+struct      histogram_s latency[OP_TYPES];
+#endif
+int         member_count = 0, insert_count = 0, delete_count = 0;
+
+/* Setup and cleanup */
+void        Usage(char* prog_name);
+void        Get_input(int* inserts_in_main_p);
+void        Merge_stats(void);
+
+/* Thread function */
+void*       Thread_work(void* rank);
+
+/* List operations */
+int         Shard(int value);
+int         Insert(int value, struct list_node_s** head_pp);
+int         Insert_batch(int values[], int n);
+int         Compare(const void* x_p, const void* y_p);
+void        Print(void);
+int         Member(int value, struct list_node_s* head_p);
+int         Delete(int value, struct list_node_s** head_pp);
+void        Free_list(void);
+struct list_node_s* Allocate_node(void);
+void        Free_node(struct list_node_s* node);
+int         Is_empty(void);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long i;
+   int j, s, batch, attempts;
+   int* keys;
+   pthread_t* thread_handles;
+   int inserts_in_main;
+   unsigned seed = 1;
+   double start, finish;
+
+   if (argc < 2 || argc > 4) Usage(argv[0]);
+   thread_count = strtol(argv[1],NULL,10);
+   if (argc >= 3) shard_count = strtol(argv[2],NULL,10);
+   if (shard_count < 1 || shard_count > MAX_KEY) Usage(argv[0]);
+   if (!Workload_init(argc == 4 ? argv[3] : "u", MAX_KEY, thread_count))
+      Usage(argv[0]);
+
+   Get_input(&inserts_in_main);
+#  ifdef NODE_POOL
+   Pool_init(sizeof(struct list_node_s));
+#  endif
+
+   shards = aligned_alloc(CACHE_LINE, shard_count*sizeof(struct shard_s));
+   for (s = 0; s < shard_count; s++) {
+      shards[s].head = NULL;
+      pthread_rwlock_init(&shards[s].rwlock, NULL);
+   }
+
+   /* Try to insert inserts_in_main keys, but give up after */
+   /* 2*inserts_in_main attempts.  The keys are generated   */
+   /* in batches, and each batch is inserted in one pass.   */
+   keys = malloc(inserts_in_main*sizeof(int));
+   i = attempts = 0;
+   while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
+      batch = inserts_in_main - i;
+      if (batch > 2*inserts_in_main - attempts)
+         batch = 2*inserts_in_main - attempts;
+      for (j = 0; j < batch; j++)
+         keys[j] = my_rand(&seed) % MAX_KEY;
+      i += Insert_batch(keys, batch);
+      attempts += batch;
+   }
+   free(keys);
+   printf("Inserted %ld keys in empty list\n", i);
+
+#  ifdef OUTPUT
+   printf("Before starting threads, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   stats = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct stats_s));
+
+   GET_TIME(start);
+   for (i = 0; i < thread_count; i++)
+      pthread_create(&thread_handles[i], NULL, Thread_work, (void*) i);
+
+   for (i = 0; i < thread_count; i++)
+      pthread_join(thread_handles[i], NULL);
+   GET_TIME(finish);
+   Merge_stats();
+   printf("Elapsed time = %e seconds\n", finish - start);
+   printf("Total ops = %d\n", total_ops);
+   printf("member ops = %d\n", member_count);
+   printf("insert ops = %d\n", insert_count);
+   printf("delete ops = %d\n", delete_count);
+#  ifdef LATENCY
+   Hist_print("member", &latency[MEMBER_OP]);
+   Hist_print("insert", &latency[INSERT_OP]);
+   Hist_print("delete", &latency[DELETE_OP]);
+#  endif
+
+#  ifdef OUTPUT
+   printf("After threads terminate, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   Free_list();
+   for (s = 0; s < shard_count; s++)
+      pthread_rwlock_destroy(&shards[s].rwlock);
+   free(shards);
+   free(stats);
+   free(thread_handles);
+#  ifdef NODE_POOL
+   Pool_destroy();
+#  endif
+
+   return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> [shard_count] [key distribution]\n",
+         prog_name);
+   fprintf(stderr, "   key distribution:  u, z[theta], s, or h[f,p]\n");
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+void Get_input(int* inserts_in_main_p) {
+
+   printf("How many keys should be inserted in the main thread?\n");
+   scanf("%d", inserts_in_main_p);
+   printf("How many ops total should be executed?\n");
+   scanf("%d", &total_ops);
+   printf("Percent of ops that should be searches? (between 0 and 1)\n");
+   scanf("%lf", &search_percent);
+   printf("Percent of ops that should be inserts? (between 0 and 1)\n");
+   scanf("%lf", &insert_percent);
+   delete_percent = 1.0 - (search_percent + insert_percent);
+}  /* Get_input */
+
+/*-----------------------------------------------------------------*/
+/* Return the subscript of the shard that stores value */
+int Shard(int value) {
+   return ((long long) value*shard_count)/MAX_KEY;
+}  /* Shard */
+
+/*-----------------------------------------------------------------*/
+/* Insert value in correct numerical location into list */
+/* If value is not in list, return 1, else return 0 */
+int Insert(int value, struct list_node_s** head_pp) {
+   struct list_node_s* curr = *head_pp;
+   struct list_node_s* pred = NULL;
+   struct list_node_s* temp;
+   int rv = 1;
+
+   while (curr != NULL && curr->data < value) {
+      pred = curr;
+      curr = curr->next;
+   }
+
+   if (curr == NULL || curr->data > value) {
+      temp = Allocate_node();
+      temp->data = value;
+      temp->next = curr;
+      if (pred == NULL)
+         *head_pp = temp;
+      else
+         pred->next = temp;
+   } else { /* value in list */
+      rv = 0;
+   }
+
+   return rv;
+}  /* Insert */
+
+/*-----------------------------------------------------------------*/
+/* Insert the n values in values[] into the shards in a single     */
+/* pass.  values[] is sorted in place, so the shards are visited   */
+/* in order.  Return number of values inserted                     */
+int Insert_batch(int values[], int n) {
+   struct list_node_s* curr = NULL;
+   struct list_node_s* pred = NULL;
+   struct list_node_s* temp;
+   int i, s, curr_shard = -1, count = 0;
+
+   qsort(values, n, sizeof(int), Compare);
+   for (i = 0; i < n; i++) {
+      if (i > 0 && values[i] == values[i-1]) continue;
+      s = Shard(values[i]);
+      if (s != curr_shard) {
+         curr_shard = s;
+         curr = shards[s].head;
+         pred = NULL;
+      }
+      while (curr != NULL && curr->data < values[i]) {
+         pred = curr;
+         curr = curr->next;
+      }
+      if (curr == NULL || curr->data > values[i]) {
+         temp = Allocate_node();
+         temp->data = values[i];
+         temp->next = curr;
+         if (pred == NULL)
+            shards[s].head = temp;
+         else
+            pred->next = temp;
+         pred = temp;
+         count++;
+      }
+   }
+
+   return count;
+}  /* Insert_batch */
+
+/*-----------------------------------------------------------------*/
+/* Compare two ints, for use by qsort */
+int Compare(const void* x_p, const void* y_p) {
+   int x = *((int*)x_p);
+   int y = *((int*)y_p);
+
+   if (x < y)
+      return -1;
+   else if (x == y)
+      return 0;
+   else /* x > y */
+      return 1;
+}  /* Compare */
+
+/*-----------------------------------------------------------------*/
+void Print(void) {
+   struct list_node_s* temp;
+   int s;
+
+   printf("list = ");
+
+   for (s = 0; s < shard_count; s++) {
+      temp = shards[s].head;
+      while (temp != (struct list_node_s*) NULL) {
+         printf("%d ", temp->data);
+         temp = temp->next;
+      }
+   }
+   printf("\n");
+}  /* Print */
+
+
+/*-----------------------------------------------------------------*/
+int  Member(int value, struct list_node_s* head_p) {
+   struct list_node_s* temp;
+
+   temp = head_p;
+   while (temp != NULL && temp->data < value)
+      temp = temp->next;
+
+   if (temp == NULL || temp->data > value) {
+#     ifdef DEBUG
+      printf("%d is not in the list\n", value);
+#     endif
+      return 0;
+   } else {
+#     ifdef DEBUG
+      printf("%d is in the list\n", value);
+#     endif
+      return 1;
+   }
+}  /* Member */
+
+/*-----------------------------------------------------------------*/
+/* Deletes value from list */
+/* If value is in list, return 1, else return 0 */
+int Delete(int value, struct list_node_s** head_pp) {
+   struct list_node_s* curr = *head_pp;
+   struct list_node_s* pred = NULL;
+   int rv = 1;
+
+   /* Find value */
+   while (curr != NULL && curr->data < value) {
+      pred = curr;
+      curr = curr->next;
+   }
+
+   if (curr != NULL && curr->data == value) {
+      if (pred == NULL) /* first element in list */
+         *head_pp = curr->next;
+      else
+         pred->next = curr->next;
+#     ifdef DEBUG
+      printf("Freeing %d\n", value);
+#     endif
+      Free_node(curr);
+   } else { /* Not in list */
+      rv = 0;
+   }
+
+   return rv;
+}  /* Delete */
+
+/*-----------------------------------------------------------------*/
+/* Get storage for a list node from the node pool or malloc */
+struct list_node_s* Allocate_node(void) {
+#  ifdef NODE_POOL
+   return Pool_alloc();
+#  else
+   return malloc(sizeof(struct list_node_s));
+#  endif
+}  /* Allocate_node */
+
+/*-----------------------------------------------------------------*/
+/* Return storage for a list node to the node pool or free it */
+void Free_node(struct list_node_s* node) {
+#  ifdef NODE_POOL
+   Pool_free(node);
+#  else
+   free(node);
+#  endif
+}  /* Free_node */
+
+/*-----------------------------------------------------------------*/
+void Free_list(void) {
+   struct list_node_s* current;
+   struct list_node_s* following;
+   int s;
+
+   for (s = 0; s < shard_count; s++) {
+      current = shards[s].head;
+      while (current != NULL) {
+#        ifdef DEBUG
+         printf("Freeing %d\n", current->data);
+#        endif
+         following = current->next;
+         Free_node(current);
+         current = following;
+      }
+      shards[s].head = NULL;
+   }
+}  /* Free_list */
+
+/*-----------------------------------------------------------------*/
+int  Is_empty(void) {
+   int s;
+
+   for (s = 0; s < shard_count; s++)
+      if (shards[s].head != NULL) return 0;
+   return 1;
+}  /* Is_empty */
+
+/*-----------------------------------------------------------------*/
+void* Thread_work(void* rank) {
+   long my_rank = (long) rank;
+   int i, val;
+   double which_op;
+   unsigned seed = my_rank + 1;
+   struct stats_s* my_stats = &stats[my_rank];
+   struct shard_s* shard_p;
+   int op;
+#  ifdef LATENCY
+   unsigned long op_start;
+#  endif
+   int ops_per_thread = total_ops/thread_count;
+
+   for (op = 0; op < OP_TYPES; op++) {
+      my_stats->count[op] = 0;
+#     ifdef LATENCY
+      Hist_init(&my_stats->latency[op]);
+#     endif
+   }
+
+   Workload_start(my_rank);
+   for (i = 0; i < ops_per_thread; i++) {
+      which_op = my_drand(&seed);
+      val = Workload_key(&seed);
+      shard_p = &shards[Shard(val)];
+#     ifdef LATENCY
+      op_start = Hist_now();
+#     endif
+      if (which_op < search_percent) {
+         pthread_rwlock_rdlock(&shard_p->rwlock);
+         Member(val, shard_p->head);
+         pthread_rwlock_unlock(&shard_p->rwlock);
+         op = MEMBER_OP;
+      } else if (which_op < search_percent + insert_percent) {
+         pthread_rwlock_wrlock(&shard_p->rwlock);
+         Insert(val, &shard_p->head);
+         pthread_rwlock_unlock(&shard_p->rwlock);
+         op = INSERT_OP;
+      } else { /* delete */
+         pthread_rwlock_wrlock(&shard_p->rwlock);
+         Delete(val, &shard_p->head);
+         pthread_rwlock_unlock(&shard_p->rwlock);
+         op = DELETE_OP;
+      }
+#     ifdef LATENCY
+      Hist_record(&my_stats->latency[op], Hist_now() - op_start);
+#     endif
+      my_stats->count[op]++;
+   }  /* for */
+
+   return NULL;
+}  /* Thread_work */
+
+/*-----------------------------------------------------------------*/
+/* Add up the threads' op counts, and merge their latency histograms */
+void Merge_stats(void) {
+   int q;
+#  ifdef LATENCY
+   int op;
+
+   for (op = 0; op < OP_TYPES; op++)
+      Hist_init(&latency[op]);
+#  endif
+   for (q = 0; q < thread_count; q++) {
+      member_count += stats[q].count[MEMBER_OP];
+      insert_count += stats[q].count[INSERT_OP];
+      delete_count += stats[q].count[DELETE_OP];
+#     ifdef LATENCY
+      for (op = 0; op < OP_TYPES; op++)
+         Hist_merge(&latency[op], &stats[q].latency[op]);
+#     endif
+   }
+}  /* Merge_stats */
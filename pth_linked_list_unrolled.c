@@ -0,0 +1,385 @@
+/* File:     pth_linked_list_unrolled.c
+ *
+ * Purpose:  Implement a multi-threaded sorted linked list of
+ *           ints with ops insert, print, member, delete, free list.
+ *           This version uses read-write locks and an "unrolled"
+ *           list:  each node stores a sorted array of up to NODE_KEYS
+ *           ints, so a search follows one pointer per NODE_KEYS keys
+ *           instead of one pointer per key.
+ *
+ * Compile:  gcc -g -Wall -o pth_linked_list_unrolled
+ *              pth_linked_list_unrolled.c my_rand.c -lpthread
+ * Usage:    ./pth_linked_list_unrolled <thread_count>
+ * Input:    total number of keys inserted by main thread
+ *           total number of ops
+ *           percent of ops that are search, insert (remainder are delete)
+ * Output:   Elapsed time to carry out the ops
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the list
+ *    2.  DEBUG compile flag used.  To get debug output compile with
+ *        -DDEBUG command line flag.
+ *    3.  The random function is not threadsafe.  So this program
+ *        uses a simple linear congruential generator.
+ *    4.  -DOUTPUT flag to gcc will show list before and after
+ *        threads have worked on it.
+ *    5.  By default NODE_KEYS = 13, so that a node (next pointer,
+ *        count, and keys) fills exactly one 64-byte cache line.  Compile
+ *        with -DNODE_KEYS=29 for two-cache-line nodes.  Nodes are
+ *        allocated on cache line boundaries.
+ *    6.  Every node in the list contains at least one key, and all
+ *        the keys in a node are less than the keys in the next node.
+ *        A full node is split in half on Insert.  On Delete, an empty
+ *        node is removed, and a node that's less than half full is
+ *        merged with its successor if they fit in one node.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "my_rand.h"
+#include "timer.h"
+
+/* Random ints are less than MAX_KEY */
+const int MAX_KEY = 100000000;
+
+#define CACHE_LINE 64
+#ifndef NODE_KEYS
+#define NODE_KEYS 13
+#endif
+
+/* Struct for list nodes:  data[0] < data[1] < ... < data[count-1] */
+struct list_node_s {
+   struct list_node_s* next;
+   int    count;
+   int    data[NODE_KEYS];
+};
+
+/* Shared variables */
+struct      list_node_s* head = NULL;
+int         thread_count;
+int         total_ops;
+double      insert_percent;
+double      search_percent;
+double      delete_percent;
+pthread_rwlock_t    rwlock;
+pthread_mutex_t     count_mutex;
+int         member_count = 0, insert_count = 0, delete_count = 0;
+
+/* Setup and cleanup */
+void        Usage(char* prog_name);
+void        Get_input(int* inserts_in_main_p);
+
+/* Thread function */
+void*       Thread_work(void* rank);
+
+/* List operations */
+struct list_node_s* Allocate_node(void);
+int         Find_slot(struct list_node_s* node, int value);
+int         Insert(int value);
+void        Print(void);
+int         Member(int value);
+int         Delete(int value);
+void        Free_list(void);
+int         Is_empty(void);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long i;
+   int key, success, attempts;
+   pthread_t* thread_handles;
+   int inserts_in_main;
+   unsigned seed = 1;
+   double start, finish;
+
+   if (argc != 2) Usage(argv[0]);
+   thread_count = strtol(argv[1],NULL,10);
+
+   Get_input(&inserts_in_main);
+
+   /* Try to insert inserts_in_main keys, but give up after */
+   /* 2*inserts_in_main attempts.                           */
+   i = attempts = 0;
+   while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
+      key = my_rand(&seed) % MAX_KEY;
+      success = Insert(key);
+      attempts++;
+      if (success) i++;
+   }
+   printf("Inserted %ld keys in empty list\n", i);
+
+#  ifdef OUTPUT
+   printf("Before starting threads, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   pthread_mutex_init(&count_mutex, NULL);
+   pthread_rwlock_init(&rwlock, NULL);
+
+   GET_TIME(start);
+   for (i = 0; i < thread_count; i++)
+      pthread_create(&thread_handles[i], NULL, Thread_work, (void*) i);
+
+   for (i = 0; i < thread_count; i++)
+      pthread_join(thread_handles[i], NULL);
+   GET_TIME(finish);
+   printf("Elapsed time = %e seconds\n", finish - start);
+   printf("Total ops = %d\n", total_ops);
+   printf("member ops = %d\n", member_count);
+   printf("insert ops = %d\n", insert_count);
+   printf("delete ops = %d\n", delete_count);
+
+#  ifdef OUTPUT
+   printf("After threads terminate, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   Free_list();
+   pthread_rwlock_destroy(&rwlock);
+   pthread_mutex_destroy(&count_mutex);
+   free(thread_handles);
+
+   return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count>\n", prog_name);
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+void Get_input(int* inserts_in_main_p) {
+
+   printf("How many keys should be inserted in the main thread?\n");
+   scanf("%d", inserts_in_main_p);
+   printf("How many ops total should be executed?\n");
+   scanf("%d", &total_ops);
+   printf("Percent of ops that should be searches? (between 0 and 1)\n");
+   scanf("%lf", &search_percent);
+   printf("Percent of ops that should be inserts? (between 0 and 1)\n");
+   scanf("%lf", &insert_percent);
+   delete_percent = 1.0 - (search_percent + insert_percent);
+}  /* Get_input */
+
+/*-----------------------------------------------------------------*/
+/* Allocate an empty node on a cache line boundary */
+struct list_node_s* Allocate_node(void) {
+   struct list_node_s* temp;
+   size_t size = (sizeof(struct list_node_s) + CACHE_LINE - 1)
+      /CACHE_LINE*CACHE_LINE;
+
+   temp = aligned_alloc(CACHE_LINE, size);
+   temp->next = NULL;
+   temp->count = 0;
+   return temp;
+}  /* Allocate_node */
+
+/*-----------------------------------------------------------------*/
+/* Return the subscript of the first key in node that's >= value, */
+/* or node->count if there isn't one                              */
+int Find_slot(struct list_node_s* node, int value) {
+   int i = 0;
+
+   while (i < node->count && node->data[i] < value)
+      i++;
+   return i;
+}  /* Find_slot */
+
+/*-----------------------------------------------------------------*/
+/* Insert value in correct numerical location into list */
+/* If value is not in list, return 1, else return 0 */
+int Insert(int value) {
+   struct list_node_s* curr = head;
+   struct list_node_s* temp;
+   int i, j, half;
+
+   if (curr == NULL) {
+      head = Allocate_node();
+      head->data[0] = value;
+      head->count = 1;
+      return 1;
+   }
+
+   /* Find the first node whose last key is >= value, or the last node */
+   while (curr->next != NULL && curr->data[curr->count-1] < value)
+      curr = curr->next;
+
+   i = Find_slot(curr, value);
+   if (i < curr->count && curr->data[i] == value) return 0;
+
+   if (curr->count == NODE_KEYS) {
+      /* Split curr:  move the upper half of its keys to a new node */
+#     ifdef DEBUG
+      printf("Splitting node starting with %d\n", curr->data[0]);
+#     endif
+      half = NODE_KEYS/2;
+      temp = Allocate_node();
+      temp->count = NODE_KEYS - half;
+      for (j = 0; j < temp->count; j++)
+         temp->data[j] = curr->data[half + j];
+      curr->count = half;
+      temp->next = curr->next;
+      curr->next = temp;
+      if (i > half) {
+         curr = temp;
+         i -= half;
+      }
+   }
+
+   for (j = curr->count; j > i; j--)
+      curr->data[j] = curr->data[j-1];
+   curr->data[i] = value;
+   curr->count++;
+
+   return 1;
+}  /* Insert */
+
+/*-----------------------------------------------------------------*/
+void Print(void) {
+   struct list_node_s* temp;
+   int i;
+
+   printf("list = ");
+
+   temp = head;
+   while (temp != (struct list_node_s*) NULL) {
+      for (i = 0; i < temp->count; i++)
+         printf("%d ", temp->data[i]);
+      temp = temp->next;
+   }
+   printf("\n");
+}  /* Print */
+
+
+/*-----------------------------------------------------------------*/
+int  Member(int value) {
+   struct list_node_s* temp;
+   int i;
+
+   temp = head;
+   while (temp != NULL && temp->data[temp->count-1] < value)
+      temp = temp->next;
+
+   if (temp != NULL) i = Find_slot(temp, value);
+   if (temp == NULL || temp->data[i] > value) {
+#     ifdef DEBUG
+      printf("%d is not in the list\n", value);
+#     endif
+      return 0;
+   } else {
+#     ifdef DEBUG
+      printf("%d is in the list\n", value);
+#     endif
+      return 1;
+   }
+}  /* Member */
+
+/*-----------------------------------------------------------------*/
+/* Deletes value from list */
+/* If value is in list, return 1, else return 0 */
+int Delete(int value) {
+   struct list_node_s* curr = head;
+   struct list_node_s* pred = NULL;
+   struct list_node_s* succ;
+   int i;
+
+   /* Find the node that would contain value */
+   while (curr != NULL && curr->data[curr->count-1] < value) {
+      pred = curr;
+      curr = curr->next;
+   }
+   if (curr == NULL) return 0;
+   i = Find_slot(curr, value);
+   if (curr->data[i] != value) return 0;
+
+   for ( ; i < curr->count-1; i++)
+      curr->data[i] = curr->data[i+1];
+   curr->count--;
+
+   if (curr->count == 0) {
+#     ifdef DEBUG
+      printf("Freeing empty node\n");
+#     endif
+      if (pred == NULL)
+         head = curr->next;
+      else
+         pred->next = curr->next;
+      free(curr);
+   } else if (curr->count < NODE_KEYS/2 && curr->next != NULL &&
+         curr->count + curr->next->count <= NODE_KEYS) {
+      /* Merge the following node into curr */
+      succ = curr->next;
+      for (i = 0; i < succ->count; i++)
+         curr->data[curr->count + i] = succ->data[i];
+      curr->count += succ->count;
+      curr->next = succ->next;
+      free(succ);
+   }
+
+   return 1;
+}  /* Delete */
+
+/*-----------------------------------------------------------------*/
+void Free_list(void) {
+   struct list_node_s* current;
+   struct list_node_s* following;
+
+   current = head;
+   while (current != NULL) {
+      following = current->next;
+      free(current);
+      current = following;
+   }
+   head = NULL;
+}  /* Free_list */
+
+/*-----------------------------------------------------------------*/
+int  Is_empty(void) {
+   if (head == NULL)
+      return 1;
+   else
+      return 0;
+}  /* Is_empty */
+
+/*-----------------------------------------------------------------*/
+void* Thread_work(void* rank) {
+   long my_rank = (long) rank;
+   int i, val;
+   double which_op;
+   unsigned seed = my_rank + 1;
+   int my_member_count = 0, my_insert_count=0, my_delete_count=0;
+   int ops_per_thread = total_ops/thread_count;
+
+   for (i = 0; i < ops_per_thread; i++) {
+      which_op = my_drand(&seed);
+      val = my_rand(&seed) % MAX_KEY;
+      if (which_op < search_percent) {
+         pthread_rwlock_rdlock(&rwlock);
+         Member(val);
+         pthread_rwlock_unlock(&rwlock);
+         my_member_count++;
+      } else if (which_op < search_percent + insert_percent) {
+         pthread_rwlock_wrlock(&rwlock);
+         Insert(val);
+         pthread_rwlock_unlock(&rwlock);
+         my_insert_count++;
+      } else { /* delete */
+         pthread_rwlock_wrlock(&rwlock);
+         Delete(val);
+         pthread_rwlock_unlock(&rwlock);
+         my_delete_count++;
+      }
+   }  /* for */
+
+   pthread_mutex_lock(&count_mutex);
+   member_count += my_member_count;
+   insert_count += my_insert_count;
+   delete_count += my_delete_count;
+   pthread_mutex_unlock(&count_mutex);
+
+   return NULL;
+}  /* Thread_work */
@@ -0,0 +1,511 @@
+/* File:     pth_skip_list.c
+ *
+ * Purpose:  Implement a multi-threaded sorted set of ints with ops
+ *           insert, print, member, delete, free list.  This version
+ *           uses a concurrent skip list, so insert, member and delete
+ *           take O(log n) time.
+ *
+ * Compile:  gcc -g -Wall -o pth_skip_list pth_skip_list.c
+ *              my_rand.c epoch.c -lpthread
+ * Usage:    ./pth_skip_list <thread_count>
+ * Input:    total number of keys inserted by main thread
+ *           total number of ops
+ *           percent of ops that are search, insert (remainder are delete)
+ * Output:   Elapsed time to carry out the ops
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the list
+ *    2.  DEBUG compile flag used.  To get debug output compile with
+ *        -DDEBUG command line flag.
+ *    3.  This is the "lazy" skip list of Herlihy, Lev, Luchangco and
+ *        Shavit.  Each node has a mutex.  Insert and Delete search
+ *        without locks, then lock the predecessors at each level and
+ *        validate them.  Member never locks.
+ *    4.  A node is in the list iff it's fully linked and unmarked.
+ *        Delete marks a node before unlinking it, and Insert sets
+ *        fully_linked after the node is linked at every level.
+ *    5.  A node's level is computed from a hash of its key, so
+ *        Insert doesn't need a per-thread random number generator.
+ *    6.  Deleted nodes are passed to Epoch_retire (see epoch.c).
+ *    7.  The random function is not threadsafe.  So this program
+ *        uses a simple linear congruential generator.
+ *    8.  -DOUTPUT flag to gcc will show list before and after
+ *        threads have worked on it.
+ *    9.  Print and Free_list should *not* be called when multiple
+ *        threads are accessing the list.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "my_rand.h"
+#include "epoch.h"
+#include "timer.h"
+
+/* Random ints are less than MAX_KEY */
+const int MAX_KEY = 100000000;
+
+/* Levels are 0, 1, ..., MAX_LEVEL-1.  Enough for ~2^MAX_LEVEL keys */
+#define MAX_LEVEL 24
+
+/* Struct for skip list nodes:  next has top_level+1 elements */
+struct skip_node_s {
+   int    data;
+   int    top_level;
+   int    marked;
+   int    fully_linked;
+   pthread_mutex_t mutex;
+   struct skip_node_s* next[];
+};
+
+/* Shared variables */
+struct      skip_node_s* head = NULL;
+int         thread_count;
+int         total_ops;
+double      insert_percent;
+double      search_percent;
+double      delete_percent;
+pthread_mutex_t     count_mutex;
+int         member_count = 0, insert_count = 0, delete_count = 0;
+
+/* Setup and cleanup */
+void        Usage(char* prog_name);
+void        Get_input(int* inserts_in_main_p);
+
+/* Thread function */
+void*       Thread_work(void* rank);
+
+/* List operations */
+struct skip_node_s* Allocate_node(int value, int top_level);
+void        Free_node(void* node);
+int         Node_level(int value);
+int         Find(int value, struct skip_node_s* preds[],
+      struct skip_node_s* succs[]);
+void        Unlock_preds(struct skip_node_s* preds[], int highest_locked);
+int         Insert(int value);
+void        Print(void);
+int         Member(int value);
+int         Delete(int value);
+void        Free_list(void);
+int         Is_empty(void);
+
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long i;
+   int key, success, attempts;
+   pthread_t* thread_handles;
+   int inserts_in_main;
+   unsigned seed = 1;
+   double start, finish;
+
+   if (argc != 2) Usage(argv[0]);
+   thread_count = strtol(argv[1],NULL,10);
+
+   Get_input(&inserts_in_main);
+
+   head = Allocate_node(-1, MAX_LEVEL-1);
+   head->fully_linked = 1;
+   Epoch_init(thread_count, Free_node);
+   Epoch_register(thread_count);
+
+   /* Try to insert inserts_in_main keys, but give up after */
+   /* 2*inserts_in_main attempts.                           */
+   i = attempts = 0;
+   while ( i < inserts_in_main && attempts < 2*inserts_in_main ) {
+      key = my_rand(&seed) % MAX_KEY;
+      success = Insert(key);
+      attempts++;
+      if (success) i++;
+   }
+   printf("Inserted %ld keys in empty list\n", i);
+
+#  ifdef OUTPUT
+   printf("Before starting threads, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   pthread_mutex_init(&count_mutex, NULL);
+
+   GET_TIME(start);
+   for (i = 0; i < thread_count; i++)
+      pthread_create(&thread_handles[i], NULL, Thread_work, (void*) i);
+
+   for (i = 0; i < thread_count; i++)
+      pthread_join(thread_handles[i], NULL);
+   GET_TIME(finish);
+   printf("Elapsed time = %e seconds\n", finish - start);
+   printf("Total ops = %d\n", total_ops);
+   printf("member ops = %d\n", member_count);
+   printf("insert ops = %d\n", insert_count);
+   printf("delete ops = %d\n", delete_count);
+
+#  ifdef OUTPUT
+   printf("After threads terminate, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   Free_list();
+   Free_node(head);
+   Epoch_destroy();
+   pthread_mutex_destroy(&count_mutex);
+   free(thread_handles);
+
+   return 0;
+}  /* main */
+
+
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count>\n", prog_name);
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+void Get_input(int* inserts_in_main_p) {
+
+   printf("How many keys should be inserted in the main thread?\n");
+   scanf("%d", inserts_in_main_p);
+   printf("How many ops total should be executed?\n");
+   scanf("%d", &total_ops);
+   printf("Percent of ops that should be searches? (between 0 and 1)\n");
+   scanf("%lf", &search_percent);
+   printf("Percent of ops that should be inserts? (between 0 and 1)\n");
+   scanf("%lf", &insert_percent);
+   delete_percent = 1.0 - (search_percent + insert_percent);
+}  /* Get_input */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Allocate_node
+ * Purpose:    Allocate and initialize a node with top_level+1 levels
+ */
+struct skip_node_s* Allocate_node(int value, int top_level) {
+   struct skip_node_s* temp;
+   int level;
+
+   temp = malloc(sizeof(struct skip_node_s) +
+         (top_level+1)*sizeof(struct skip_node_s*));
+   temp->data = value;
+   temp->top_level = top_level;
+   temp->marked = 0;
+   temp->fully_linked = 0;
+   pthread_mutex_init(&(temp->mutex), NULL);
+   for (level = 0; level <= top_level; level++)
+      temp->next[level] = NULL;
+   return temp;
+}  /* Allocate_node */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Free_node
+ * Purpose:    Destroy a node's mutex and free it.  Called by the
+ *             epoch module when a retired node can be reclaimed.
+ */
+void Free_node(void* node) {
+   struct skip_node_s* node_p = node;
+
+#  ifdef DEBUG
+   printf("Freeing %d\n", node_p->data);
+#  endif
+   pthread_mutex_destroy(&(node_p->mutex));
+   free(node_p);
+}  /* Free_node */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Node_level
+ * Purpose:    Choose the top level of the node for value:  level l
+ *             is chosen with probability 1/2^(l+1)
+ * Note:       The key is scrambled with a multiplicative hash, since
+ *             the low-order bits of consecutive keys aren't random
+ */
+int Node_level(int value) {
+   unsigned h = (unsigned) value * 2654435761U;
+   int level;
+
+   h ^= h >> 15;
+   h *= 2246822519U;
+   h ^= h >> 13;
+   level = __builtin_ctz(h | (1U << (MAX_LEVEL-1)));
+   return level;
+}  /* Node_level */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Find
+ * Purpose:     Search the list for value without locking
+ * In arg:      value
+ * Out args:    preds[l]:  last node at level l with data < value
+ *              succs[l]:  node following preds[l] at level l (or NULL)
+ * Return val:  The highest level at which a node containing value
+ *              was found, -1 if it wasn't found
+ * Note:        Caller must be in an epoch critical section
+ */
+int Find(int value, struct skip_node_s* preds[],
+      struct skip_node_s* succs[]) {
+   int level, l_found = -1;
+   struct skip_node_s* pred = head;
+   struct skip_node_s* curr;
+
+   for (level = MAX_LEVEL-1; level >= 0; level--) {
+      curr = __atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE);
+      while (curr != NULL && curr->data < value) {
+         pred = curr;
+         curr = __atomic_load_n(&pred->next[level], __ATOMIC_ACQUIRE);
+      }
+      if (l_found == -1 && curr != NULL && curr->data == value)
+         l_found = level;
+      preds[level] = pred;
+      succs[level] = curr;
+   }
+   return l_found;
+}  /* Find */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Unlock_preds
+ * Purpose:    Unlock preds[0], ..., preds[highest_locked].  A node
+ *             may be the predecessor at several consecutive levels,
+ *             but it's only locked once.
+ */
+void Unlock_preds(struct skip_node_s* preds[], int highest_locked) {
+   int level;
+
+   for (level = 0; level <= highest_locked; level++)
+      if (level == 0 || preds[level] != preds[level-1])
+         pthread_mutex_unlock(&(preds[level]->mutex));
+}  /* Unlock_preds */
+
+/*-----------------------------------------------------------------*/
+/* Insert value in correct numerical location into list */
+/* If value is not in list, return 1, else return 0 */
+int Insert(int value) {
+   struct skip_node_s* preds[MAX_LEVEL];
+   struct skip_node_s* succs[MAX_LEVEL];
+   struct skip_node_s* pred;
+   struct skip_node_s* succ;
+   struct skip_node_s* prev_pred;
+   struct skip_node_s* found;
+   struct skip_node_s* temp;
+   int top_level = Node_level(value);
+   int level, l_found, highest_locked, valid;
+
+   Epoch_enter();
+   while (1) {
+      l_found = Find(value, preds, succs);
+      if (l_found != -1) {
+         found = succs[l_found];
+         if (!__atomic_load_n(&found->marked, __ATOMIC_ACQUIRE)) {
+            /* Wait for the inserting thread to finish */
+            while (!__atomic_load_n(&found->fully_linked, __ATOMIC_ACQUIRE));
+            Epoch_exit();
+            return 0;
+         }
+         continue;
+      }
+
+      /* Lock and validate the predecessors, from the bottom up */
+      highest_locked = -1;
+      prev_pred = NULL;
+      valid = 1;
+      for (level = 0; valid && level <= top_level; level++) {
+         pred = preds[level];
+         succ = succs[level];
+         if (pred != prev_pred) {
+            pthread_mutex_lock(&(pred->mutex));
+            highest_locked = level;
+            prev_pred = pred;
+         }
+         valid = !pred->marked && (succ == NULL ||
+               !__atomic_load_n(&succ->marked, __ATOMIC_ACQUIRE)) &&
+            pred->next[level] == succ;
+      }
+      if (!valid) {
+         Unlock_preds(preds, highest_locked);
+         continue;
+      }
+
+#     ifdef DEBUG
+      printf("Inserting %d at levels 0-%d\n", value, top_level);
+#     endif
+      temp = Allocate_node(value, top_level);
+      for (level = 0; level <= top_level; level++)
+         temp->next[level] = succs[level];
+      for (level = 0; level <= top_level; level++)
+         __atomic_store_n(&preds[level]->next[level], temp, __ATOMIC_RELEASE);
+      __atomic_store_n(&temp->fully_linked, 1, __ATOMIC_RELEASE);
+      Unlock_preds(preds, highest_locked);
+      Epoch_exit();
+      return 1;
+   }
+}  /* Insert */
+
+/*-----------------------------------------------------------------*/
+void Print(void) {
+   struct skip_node_s* temp;
+
+   printf("list = ");
+
+   temp = head->next[0];
+   while (temp != (struct skip_node_s*) NULL) {
+      printf("%d ", temp->data);
+      temp = temp->next[0];
+   }
+   printf("\n");
+}  /* Print */
+
+
+/*-----------------------------------------------------------------*/
+int  Member(int value) {
+   struct skip_node_s* preds[MAX_LEVEL];
+   struct skip_node_s* succs[MAX_LEVEL];
+   int l_found, rv;
+
+   Epoch_enter();
+   l_found = Find(value, preds, succs);
+   rv = l_found != -1 &&
+      __atomic_load_n(&succs[l_found]->fully_linked, __ATOMIC_ACQUIRE) &&
+      !__atomic_load_n(&succs[l_found]->marked, __ATOMIC_ACQUIRE);
+   Epoch_exit();
+
+   if (!rv) {
+#     ifdef DEBUG
+      printf("%d is not in the list\n", value);
+#     endif
+      return 0;
+   } else {
+#     ifdef DEBUG
+      printf("%d is in the list\n", value);
+#     endif
+      return 1;
+   }
+}  /* Member */
+
+/*-----------------------------------------------------------------*/
+/* Deletes value from list */
+/* If value is in list, return 1, else return 0 */
+int Delete(int value) {
+   struct skip_node_s* preds[MAX_LEVEL];
+   struct skip_node_s* succs[MAX_LEVEL];
+   struct skip_node_s* victim = NULL;
+   struct skip_node_s* pred;
+   struct skip_node_s* prev_pred;
+   int is_marked = 0, top_level = -1;
+   int level, l_found, highest_locked, valid;
+
+   Epoch_enter();
+   while (1) {
+      l_found = Find(value, preds, succs);
+      if (!is_marked) {
+         /* Only delete a node that's fully linked and found at */
+         /* its top level                                        */
+         if (l_found == -1) break;
+         victim = succs[l_found];
+         if (!__atomic_load_n(&victim->fully_linked, __ATOMIC_ACQUIRE) ||
+               victim->top_level != l_found ||
+               __atomic_load_n(&victim->marked, __ATOMIC_ACQUIRE))
+            break;
+         top_level = victim->top_level;
+         pthread_mutex_lock(&(victim->mutex));
+         if (victim->marked) {
+            pthread_mutex_unlock(&(victim->mutex));
+            break;
+         }
+         /* Logical deletion */
+         __atomic_store_n(&victim->marked, 1, __ATOMIC_RELEASE);
+         is_marked = 1;
+      }
+
+      /* Lock and validate the predecessors, from the bottom up */
+      highest_locked = -1;
+      prev_pred = NULL;
+      valid = 1;
+      for (level = 0; valid && level <= top_level; level++) {
+         pred = preds[level];
+         if (pred != prev_pred) {
+            pthread_mutex_lock(&(pred->mutex));
+            highest_locked = level;
+            prev_pred = pred;
+         }
+         valid = !pred->marked && pred->next[level] == victim;
+      }
+      if (!valid) {
+         Unlock_preds(preds, highest_locked);
+         continue;
+      }
+
+      /* Physical deletion, from the top down */
+#     ifdef DEBUG
+      printf("Deleting %d\n", value);
+#     endif
+      for (level = top_level; level >= 0; level--)
+         __atomic_store_n(&preds[level]->next[level], victim->next[level],
+               __ATOMIC_RELEASE);
+      pthread_mutex_unlock(&(victim->mutex));
+      Unlock_preds(preds, highest_locked);
+      Epoch_retire(victim);
+      Epoch_exit();
+      return 1;
+   }
+
+   Epoch_exit();
+   return 0;
+}  /* Delete */
+
+/*-----------------------------------------------------------------*/
+/* Doesn't lock.  Can only be run when no other threads are
+ * accessing the list
+ */
+void Free_list(void) {
+   struct skip_node_s* current;
+   struct skip_node_s* following;
+   int level;
+
+   current = head->next[0];
+   while (current != NULL) {
+      following = current->next[0];
+      Free_node(current);
+      current = following;
+   }
+   for (level = 0; level < MAX_LEVEL; level++)
+      head->next[level] = NULL;
+}  /* Free_list */
+
+/*-----------------------------------------------------------------*/
+int  Is_empty(void) {
+   if (head->next[0] == NULL)
+      return 1;
+   else
+      return 0;
+}  /* Is_empty */
+
+/*-----------------------------------------------------------------*/
+void* Thread_work(void* rank) {
+   long my_rank = (long) rank;
+   int i, val;
+   double which_op;
+   unsigned seed = my_rank + 1;
+   int my_member_count = 0, my_insert_count=0, my_delete_count=0;
+   int ops_per_thread = total_ops/thread_count;
+
+   Epoch_register(my_rank);
+   for (i = 0; i < ops_per_thread; i++) {
+      which_op = my_drand(&seed);
+      val = my_rand(&seed) % MAX_KEY;
+      if (which_op < search_percent) {
+         Member(val);
+         my_member_count++;
+      } else if (which_op < search_percent + insert_percent) {
+         Insert(val);
+         my_insert_count++;
+      } else { /* delete */
+         Delete(val);
+         my_delete_count++;
+      }
+   }  /* for */
+
+   pthread_mutex_lock(&count_mutex);
+   member_count += my_member_count;
+   insert_count += my_insert_count;
+   delete_count += my_delete_count;
+   pthread_mutex_unlock(&count_mutex);
+
+   return NULL;
+}  /* Thread_work */
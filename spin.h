@@ -0,0 +1,41 @@
+/* File:     spin.h
+ * Purpose:  Spin-wait helper shared by the programs whose threads wait
+ *           for a flag or counter set by another thread.
+ *
+ * Notes:
+ * 1.  Spin_pause is defined here, as a static inline function, so a
+ *     program doesn't need another source file on its compile line.
+ * 2.  On x86 each spin executes a pause instruction.  On other
+ *     targets it's just a compiler barrier, so the waiting loop
+ *     reloads the flag it's waiting for.
+ * 3.  After SPIN_LIMIT spins the waiting thread calls sched_yield,
+ *     so the program still makes progress when there are more
+ *     threads than cores.
+ */
+#ifndef _SPIN_H_
+#define _SPIN_H_
+
+#include <sched.h>
+
+#define SPIN_LIMIT 100
+
+/*-----------------------------------------------------------------*/
+/* Function:   Spin_pause
+ * Purpose:    Wait a little while in a spin loop.  After SPIN_LIMIT
+ *             calls, yield the processor.
+ * In/out arg: spins_p, the number of calls so far
+ */
+static inline void Spin_pause(int* spins_p) {
+   if (*spins_p < SPIN_LIMIT) {
+      (*spins_p)++;
+#     if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#     else
+      __asm__ __volatile__("" ::: "memory");
+#     endif
+   } else {
+      sched_yield();
+   }
+}  /* Spin_pause */
+
+#endif
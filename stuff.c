@@ -1,310 +1,837 @@
-/*
- 
- Compile:   gcc -g -Wall -o pth stuff.c my_rand.c -lpthread
- Run:       ./pth 3
- 
- 
-Each thread and the main thread can carry 
-out an insert, delete, or member.  Use Pthreads read-write 
-locks to ensure that any number of threads can execute 
-member simultaneously, but if a thread needs to insert 
-or delete, it will obtain exclusive access to the list.
-
-For the second part of the program you should build a 
-"task queue".  The main thread begins by starting a 
-user-specified number of threads that immediately go t
-o sleep in a condition wait. The main thread reads in blocks 
-of tasks to be carried out by the other threads; each time 
-it generates a new block of tasks, it awakens a thread with 
-a condition signal. When a thread finishes executing its 
-block of tasks, it should return to a condition wait. 
-When the main thread completes generating tasks, it sets 
-a global variable indicating that there will be no more 
-tasks, and awakens all the threads with a condition broadcast.
-
-Input will be a list of blocks of tasks.  The tasks are 
-linked list operations, which can be represented as a pair.   
-The first element of the pair is a char representing the 
-operation:  'i' for insert, 'd' for delete, and 'm' for 
-member.  The second element is a value to be inserted, 
-deleted, or searched for.  A block of tasks is also a pair.  
-It consists of an array of tasks and an int specifying the 
-number of tasks.  
-
-The main thread should read one block of tasks at a time 
-and store it in memory.  Then it should execute a condition 
-signal, and the task it awakens should carry out the 
-specified operations.  
-
-When there is no more input, the main thread should print 
-the linked list, and which operations were carried out by 
-which threads.
-*/
+/* File:     stuff.c
+ *
+ * Purpose:  Use a task queue to carry out operations on a sorted
+ *           linked list of ints that's shared by the threads.  The
+ *           main thread reads (or generates) blocks of tasks and puts
+ *           them on a queue, and the threads take blocks off the queue
+ *           and carry out the tasks.  The list is protected by a
+ *           Pthreads read-write lock.
+ *
+ * Compile:  gcc -g -Wall -o pth stuff.c my_rand.c -lpthread
+ * Usage:    ./pth <thread_count> [options]
+ *           options:  any of
+ *              g = generate the tasks instead of reading them,
+ *              s = split the blocks into chunks and use work stealing
+ * Input:    number of keys inserted by main thread
+ *           number of blocks of tasks
+ *           number of tasks per block
+ *           Without g:  the tasks, each a char and an int, e.g. "i 42".
+ *              The char is 'i' for insert, 'd' for delete, and 'm' for
+ *              member.
+ *           With g:  percent of tasks that are member, insert
+ *              (remainder are delete).  The tasks are generated.
+ * Output:   Elapsed time to carry out the tasks, and the number of
+ *           each type of task carried out by each thread
+ *
+ * Notes:
+ *    1.  Repeated values are not allowed in the list
+ *    2.  -DOUTPUT flag to gcc will show list before and after
+ *        threads have worked on it.
+ *    3.  There are QUEUE_SIZE blocks.  They start on the queue of
+ *        empty blocks.  The main thread takes an empty block, fills it
+ *        with tasks, and puts it on the queue of full blocks.  A thread
+ *        takes full blocks, carries out their tasks, and puts the
+ *        blocks back on the empty queue.  So the storage for the tasks
+ *        is allocated once, and if the threads fall behind, the main
+ *        thread waits for an empty block instead of allocating more.
+ *    4.  The queues are bounded circular buffers that can be used by
+ *        any number of producers and consumers.  Each has a mutex and
+ *        two condition variables:  a consumer waits on not_empty when
+ *        the queue is empty, and a producer waits on not_full when it's
+ *        full.  A thread only signals a condition variable when some
+ *        thread is waiting on it.
+ *    5.  Dequeue takes up to BATCH blocks at once, so that a thread
+ *        acquires the queue's mutex once for several blocks when the
+ *        queue is busy.
+ *    6.  When there are no more tasks, the main thread calls Finish,
+ *        which sets the queue's done flag and wakes all the waiting
+ *        threads with a condition broadcast.  Dequeue returns 0 when
+ *        the queue is empty and done.
+ *    7.  A thread holds the read-write lock for a run of up to
+ *        LOCK_RUN consecutive tasks in a block that need the same
+ *        kind of lock:  read for member, write for insert and delete.
+ *    8.  The random function is not threadsafe.  So this program
+ *        uses a simple linear congruential generator.
+ *    9.  past.c is an earlier version of this program.
+ *   10.  With option s each thread has its own Chase-Lev deque of
+ *        chunks of at most CHUNK tasks.  A thread that takes a block
+ *        off the full queue splits it into chunks and pushes them onto
+ *        the bottom of its deque.  It pops chunks from the bottom, and
+ *        when its deque is empty, it tries to steal a chunk from the
+ *        top of the other threads' deques before it goes back to the
+ *        full queue.  So if one block is much bigger than the others,
+ *        the threads that are idle share its tasks instead of waiting.
+ *   11.  A thread only pushes chunks when its deque is empty, so a
+ *        deque never holds more than BATCH blocks' worth of chunks,
+ *        and its array doesn't have to grow.
+ *   12.  The chunks of a block are counted down as they're finished,
+ *        and the thread that finishes the last one puts the block on
+ *        the empty queue.
+ *   13.  When a thread pushes more than one chunk, it wakes the
+ *        threads that are waiting for the full queue, so they can
+ *        steal.  A thread that fails to steal just before the chunks
+ *        are pushed can miss the wakeup, but the chunks are still
+ *        carried out by their owner.
+ */
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include "my_rand.h"
+#include "timer.h"
+
+/* Random ints are less than MAX_KEY */
+const int MAX_KEY = 100000000;
+
+#define QUEUE_SIZE 64    /* Number of blocks */
+#define BATCH 4          /* Most blocks taken by one Dequeue */
+#define LOCK_RUN 32      /* Most tasks carried out with one lock */
+#define CHUNK 64         /* Most tasks in a chunk that can be stolen */
+#define CACHE_LINE 64
+#define MEMBER_OP 0
+#define INSERT_OP 1
+#define DELETE_OP 2
+#define OP_TYPES 3
+
+/* Struct for list nodes */
+struct list_node_s {
+   int    data;
+   struct list_node_s* next;
+};
+
+/* Struct for the tasks */
+struct task {
+   char operation;
+   int number;
+};
 
+/* A block of tasks */
+struct block_s {
+   struct task* tasks;
+   int count;
+   struct chunk_s* chunks;     /* Used with work stealing */
+   int remaining;              /* Chunks not yet finished */
+};
 
-const int MAX = 100000000;  /* Random ints are less than MAX_KEY */
-int thread_count;  //# of threads, and number of blocks to be used
-int total_tasks; //# of tasks to be performed
+/* Part of a block that is carried out by one thread */
+struct chunk_s {
+   struct block_s* block_p;
+   int start;
+   int count;
+};
+
+/* Chase-Lev work-stealing deque of pointers to chunks.  The owner */
+/* pushes and pops at bottom, and the other threads steal at top.  */
+struct deque_s {
+   long top;
+   char pad[CACHE_LINE - sizeof(long)];
+   long bottom;
+   struct chunk_s** buffer;
+   long mask;                  /* Size of buffer - 1 */
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Bounded queue of pointers to blocks */
+struct queue_s {
+   struct block_s* blocks[QUEUE_SIZE];
+   int front;            /* Subscript of next block to dequeue */
+   int count;            /* Number of blocks in queue */
+   int done;             /* No more blocks will be enqueued */
+   int consumers_waiting;
+   int producers_waiting;
+   int wakeups;          /* Incremented by Wake_consumers */
+   pthread_mutex_t mutex;
+   pthread_cond_t  not_empty;
+   pthread_cond_t  not_full;
+};
+
+/* Per-thread counts, padded to a multiple of the cache line size */
+struct stats_s {
+   int    count[OP_TYPES];     /* Tasks carried out */
+   int    success[OP_TYPES];   /* Tasks that found or changed the list */
+   int    steals;              /* Chunks stolen from other threads */
+} __attribute__((aligned(CACHE_LINE)));
+
+/* Shared variables */
+struct      list_node_s* head = NULL;
+int         thread_count;
+int         steal = 0;
+int         chunks_per_block;
 pthread_rwlock_t rwlock;
-pthread_mutex_t count_mutex;
-pthread_cond_t condition;
-int inserts = 0; //# of items in the list to start with (for delete)
-int global = 0; //tells if the # of operations have been completed
-struct list_node_s* head = NULL;
+struct      queue_s full_queue, empty_queue;
+struct      stats_s* stats;
+struct      deque_s* deques;
+
+/* Setup and cleanup */
+void        Usage(char* prog_name);
+void        Get_input(int* inserts_in_main_p, int* block_count_p,
+               int* block_size_p);
+int         Read_block(struct block_s* block_p, int block_size);
+void        Generate_block(struct block_s* block_p, int block_size,
+               double search_percent, double insert_percent,
+               unsigned* seed_p);
+void        Print_stats(void);
+
+/* Thread function */
+void*       Thread_work(void* rank);
+void        Work_from_queue(struct stats_s* my_stats);
+void        Work_stealing(long my_rank, struct stats_s* my_stats);
+void        Execute_tasks(struct task tasks[], int count,
+               struct stats_s* my_stats);
+
+/* Queue operations */
+void        Queue_init(struct queue_s* q_p);
+void        Enqueue(struct queue_s* q_p, struct block_s* blocks[], int n);
+int         Dequeue(struct queue_s* q_p, struct block_s* blocks[], int max);
+void        Finish(struct queue_s* q_p);
+void        Wake_consumers(struct queue_s* q_p);
+void        Queue_destroy(struct queue_s* q_p);
+
+/* Deque operations */
+void        Deque_init(struct deque_s* d_p, long size);
+void        Push_bottom(struct deque_s* d_p, struct chunk_s* chunk_p);
+struct chunk_s* Pop_bottom(struct deque_s* d_p);
+struct chunk_s* Steal_top(struct deque_s* d_p);
+struct chunk_s* Steal_chunk(long my_rank, unsigned* seed_p);
+void        Deque_destroy(struct deque_s* d_p);
+
+/* List operations */
+int         Insert(int value);
+void        Print(void);
+int         Member(int value);
+int         Delete(int value);
+void        Free_list(void);
 
+/*-----------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+   long i, task_count = 0, deque_size;
+   char* option;
+   int b, inserts_in_main, block_count, block_size, generate = 0;
+   unsigned seed = 1;
+   double search_percent = 0.0, insert_percent = 0.0;
+   double start, finish;
+   pthread_t* thread_handles;
+   struct block_s* blocks;
+   struct block_s* block_p;
+
+   if (argc != 2 && argc != 3) Usage(argv[0]);
+   thread_count = strtol(argv[1], NULL, 10);
+   if (thread_count < 1) Usage(argv[0]);
+   if (argc == 3) {
+      for (option = argv[2]; *option != '\0'; option++) {
+         if (*option == 'g')
+            generate = 1;
+         else if (*option == 's')
+            steal = 1;
+         else
+            Usage(argv[0]);
+      }
+   }
 
+   Get_input(&inserts_in_main, &block_count, &block_size);
+   if (generate) {
+      printf("Percent of tasks that should be searches? (between 0 and 1)\n");
+      scanf("%lf", &search_percent);
+      printf("Percent of tasks that should be inserts? (between 0 and 1)\n");
+      scanf("%lf", &insert_percent);
+   }
 
-// ********************* GLOBAL THREAD CONDITIONAL VARIABLES ***************
-int counter = 0;
-pthread_mutex_t mutex;
-pthread_cond_t cond_var;
-// ********************* GLOBAL THREAD CONDITIONAL VARIABLES ***************
+   /* Try to insert inserts_in_main keys, but give up after */
+   /* 2*inserts_in_main attempts.                           */
+   i = b = 0;
+   while ( i < inserts_in_main && b < 2*inserts_in_main ) {
+      if (Insert(my_rand(&seed) % MAX_KEY))
+         i++;
+      b++;
+   }
+   printf("Inserted %ld keys in empty list\n", i);
 
+#  ifdef OUTPUT
+   printf("Before starting threads, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   /* All of the blocks start on the empty queue */
+   Queue_init(&full_queue);
+   Queue_init(&empty_queue);
+   blocks = malloc(QUEUE_SIZE*sizeof(struct block_s));
+   chunks_per_block = (block_size + CHUNK - 1)/CHUNK;
+   for (b = 0; b < QUEUE_SIZE; b++) {
+      blocks[b].tasks = malloc(block_size*sizeof(struct task));
+      blocks[b].count = 0;
+      blocks[b].chunks = steal ?
+         malloc(chunks_per_block*sizeof(struct chunk_s)) : NULL;
+      block_p = &blocks[b];
+      Enqueue(&empty_queue, &block_p, 1);
+   }
 
+   thread_handles = malloc(thread_count*sizeof(pthread_t));
+   stats = aligned_alloc(CACHE_LINE, thread_count*sizeof(struct stats_s));
+   if (steal) {
+      deques = aligned_alloc(CACHE_LINE,
+            thread_count*sizeof(struct deque_s));
+      deque_size = 1;
+      while (deque_size < BATCH*chunks_per_block)
+         deque_size *= 2;
+      for (i = 0; i < thread_count; i++)
+         Deque_init(&deques[i], deque_size);
+   }
+   pthread_rwlock_init(&rwlock, NULL);
+
+   GET_TIME(start);
+   for (i = 0; i < thread_count; i++)
+      pthread_create(&thread_handles[i], NULL, Thread_work, (void*) i);
+
+   for (b = 0; b < block_count; b++) {
+      Dequeue(&empty_queue, &block_p, 1);
+      if (generate)
+         Generate_block(block_p, block_size, search_percent,
+               insert_percent, &seed);
+      else if (!Read_block(block_p, block_size)) {
+         Enqueue(&empty_queue, &block_p, 1);
+         break;
+      }
+      task_count += block_p->count;
+      Enqueue(&full_queue, &block_p, 1);
+   }
+   Finish(&full_queue);
+
+   for (i = 0; i < thread_count; i++)
+      pthread_join(thread_handles[i], NULL);
+   GET_TIME(finish);
+   printf("Elapsed time = %e seconds\n", finish - start);
+   Print_stats();
+   printf("Tasks per second = %e\n",
+         (finish > start) ? task_count/(finish - start) : 0.0);
+
+#  ifdef OUTPUT
+   printf("After threads terminate, list = \n");
+   Print();
+   printf("\n");
+#  endif
+
+   Free_list();
+   pthread_rwlock_destroy(&rwlock);
+   Queue_destroy(&full_queue);
+   Queue_destroy(&empty_queue);
+   if (steal) {
+      for (i = 0; i < thread_count; i++)
+         Deque_destroy(&deques[i]);
+      free(deques);
+   }
+   for (b = 0; b < QUEUE_SIZE; b++) {
+      free(blocks[b].tasks);
+      free(blocks[b].chunks);
+   }
+   free(blocks);
+   free(stats);
+   free(thread_handles);
 
-struct list_node_s                  /* Struct for list nodes */
-{
-   int data;
-   struct list_node_s* next;
-};
+   return 0;
+}  /* main */
 
-struct task                         /* Struct for the tasks */
-{
-   char operation;
-   int number;
-};
 
-void Usage(char* prog_name);
-void Insert(int value);
-void Delete(int value); 
-void Member(int value);  
-void Print(void);
-void Get_input(int* inserts_p);
-void* Spawn_Threads(void* rank);
-
-
-
-int main(int argc, char* argv[])
-{
-// *************************** LOCAL VARIABLES ******************************
-    char op;
-    unsigned seed = 1;
-    long i = 0, thread;
-    pthread_t* thread_handles;
-    int inserts, number, num, blocks, block_count = 0;
-// *************************** LOCAL VARIABLES ******************************
-
-    
-   //make sure the proper amount of arguments are being used
-   //then enter the number of threads to a variable from args
-   if (argc != 2) {
-      Usage(argv[0]);
+/*-----------------------------------------------------------------*/
+void Usage(char* prog_name) {
+   fprintf(stderr, "usage: %s <thread_count> [options]\n", prog_name);
+   fprintf(stderr, "   options:  any of\n");
+   fprintf(stderr, "   g:  generate the tasks instead of reading them\n");
+   fprintf(stderr, "   s:  split the blocks into chunks and use work stealing\n");
+   exit(0);
+}  /* Usage */
+
+/*-----------------------------------------------------------------*/
+void Get_input(int* inserts_in_main_p, int* block_count_p,
+      int* block_size_p) {
+
+   printf("How many keys should be inserted in the main thread?\n");
+   scanf("%d", inserts_in_main_p);
+   printf("How many blocks of tasks would you like?\n");
+   scanf("%d", block_count_p);
+   printf("How many tasks per block?\n");
+   scanf("%d", block_size_p);
+   if (*block_size_p < 1) *block_size_p = 1;
+}  /* Get_input */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Read_block
+ * Purpose:     Read up to block_size tasks from stdin into a block
+ * Return val:  0 if there was no more input, 1 otherwise
+ * Note:        Tasks with an invalid op are reported and skipped
+ */
+int Read_block(struct block_s* block_p, int block_size) {
+   char op;
+   int value;
+
+   block_p->count = 0;
+   while (block_p->count < block_size &&
+         scanf(" %c %d", &op, &value) == 2) {
+      if (op != 'i' && op != 'd' && op != 'm') {
+         fprintf(stderr, "%c is an invalid operation\n", op);
+         continue;
+      }
+      block_p->tasks[block_p->count].operation = op;
+      block_p->tasks[block_p->count].number = value;
+      block_p->count++;
+   }
+   return block_p->count > 0;
+}  /* Read_block */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Generate_block
+ * Purpose:     Fill a block with random tasks
+ */
+void Generate_block(struct block_s* block_p, int block_size,
+      double search_percent, double insert_percent, unsigned* seed_p) {
+   int t;
+   double which_op;
+
+   for (t = 0; t < block_size; t++) {
+      which_op = my_drand(seed_p);
+      if (which_op < search_percent)
+         block_p->tasks[t].operation = 'm';
+      else if (which_op < search_percent + insert_percent)
+         block_p->tasks[t].operation = 'i';
+      else
+         block_p->tasks[t].operation = 'd';
+      block_p->tasks[t].number = my_rand(seed_p) % MAX_KEY;
    }
-    thread_count = strtol(argv[1], NULL, 10);
+   block_p->count = block_size;
+}  /* Generate_block */
 
-   //figure out how many numbers to enter in the list
-   Get_input(&inserts);  
+/*-----------------------------------------------------------------*/
+/* Function:    Print_stats
+ * Purpose:     Print which ops were carried out by which threads
+ */
+void Print_stats(void) {
+   long q;
+   int totals[OP_TYPES] = {0, 0, 0};
+
+   for (q = 0; q < thread_count; q++) {
+      printf("Thread %ld:  inserts = %d (%d new), deletes = %d "
+            "(%d found), members = %d (%d found)\n", q,
+            stats[q].count[INSERT_OP], stats[q].success[INSERT_OP],
+            stats[q].count[DELETE_OP], stats[q].success[DELETE_OP],
+            stats[q].count[MEMBER_OP], stats[q].success[MEMBER_OP]);
+      if (steal)
+         printf("           chunks stolen = %d\n", stats[q].steals);
+      totals[INSERT_OP] += stats[q].count[INSERT_OP];
+      totals[DELETE_OP] += stats[q].count[DELETE_OP];
+      totals[MEMBER_OP] += stats[q].count[MEMBER_OP];
+   }
+   printf("Total tasks = %d\n",
+         totals[INSERT_OP] + totals[DELETE_OP] + totals[MEMBER_OP]);
+   printf("member ops = %d\n", totals[MEMBER_OP]);
+   printf("insert ops = %d\n", totals[INSERT_OP]);
+   printf("delete ops = %d\n", totals[DELETE_OP]);
+}  /* Print_stats */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Thread_work
+ * Purpose:     Carry out the tasks in the blocks on the full queue
+ *              until the queue is empty and done
+ */
+void* Thread_work(void* rank) {
+   long my_rank = (long) rank;
+   struct stats_s* my_stats = &stats[my_rank];
+   int op;
+
+   for (op = 0; op < OP_TYPES; op++)
+      my_stats->count[op] = my_stats->success[op] = 0;
+   my_stats->steals = 0;
+
+   if (steal)
+      Work_stealing(my_rank, my_stats);
+   else
+      Work_from_queue(my_stats);
+
+   return NULL;
+}  /* Thread_work */
 
-   while (i < inserts)
-   {
-      number = my_rand(&seed) % MAX;
-      Insert(number);
-      i ++;
+/*-----------------------------------------------------------------*/
+/* Function:    Work_from_queue
+ * Purpose:     Take blocks off the full queue and carry out all of
+ *              their tasks
+ */
+void Work_from_queue(struct stats_s* my_stats) {
+   struct block_s* my_blocks[BATCH];
+   int b, n;
+
+   while ((n = Dequeue(&full_queue, my_blocks, BATCH)) > 0) {
+      for (b = 0; b < n; b++)
+         Execute_tasks(my_blocks[b]->tasks, my_blocks[b]->count, my_stats);
+      Enqueue(&empty_queue, my_blocks, n);
    }
-   printf("This is the list before threads are started.\n");
-   Print();
-    
-    //  ***************** NEW function startThreads() *****************
-    printf("Starting thread creation.\n");
-    thread_handles = malloc(thread_count * sizeof(pthread_t));
-    printf("Hello from the main thread\n");
-
-    // create the user specified # of threads
-    for (thread = 0; thread < thread_count; thread++)
-        pthread_create(&thread_handles[thread], NULL, Spawn_Threads, (void*) thread);
-    
-    //immediately go to sleep
-    // pthread_cond_wait(&condition, &mutex);
-
-    //main thread asks for a # of how many blocks to execute
-    printf("How many blocks of tasks would you like?\n");
-    scanf("%d", &blocks);
-    //then how many tasks should be in each block
-    printf("How many tasks per block?\n");
-    scanf("%d", &total_tasks);
-    //and creates a list for those tasks
-    struct task* list = (struct task*)
-      malloc(total_tasks * sizeof(struct task));
-    // if(global ==  0){
-      // Just add this logic to Hello() for each thread to execute it.
-      // Not sure how to have the threads spawn inside of main
-      // They are spawned and call Hello() then terminate.
-      for(int j = 0; j < blocks; j ++)
-      {
-          printf("Please enter an operation, and a number\n");
-          scanf("%c %d", &op, &num);
-
-          for (int k = 0; k < total_tasks; k ++)
-          {
-              //Spawn_Threads( (void*) thread );
-              (list + j) -> operation = op;
-              (list + j) -> number = num;
-          }
-          // pthread_cond_signal(&condition);
-          //execute the block of tasks
-          //add in switch case for list of tasks
-          // ExecuteTasks(&list);
-          // pthread_cond_wait(&condition, &mutex);
+}  /* Work_from_queue */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Work_stealing
+ * Purpose:     Carry out chunks from this thread's deque.  When it's
+ *              empty, steal a chunk from another thread, and if there
+ *              aren't any, take blocks off the full queue and split
+ *              them into chunks.
+ * Note:        When the full queue is done, the thread quits after
+ *              it fails to steal:  any chunks left in the other deques
+ *              will be carried out by their owners.
+ */
+void Work_stealing(long my_rank, struct stats_s* my_stats) {
+   struct deque_s* my_deque = &deques[my_rank];
+   struct block_s* my_blocks[BATCH];
+   struct block_s* block_p;
+   struct chunk_s* chunk_p;
+   unsigned seed = my_rank + 1;
+   int b, c, n;
+
+   while (1) {
+      chunk_p = Pop_bottom(my_deque);
+      if (chunk_p == NULL) {
+         chunk_p = Steal_chunk(my_rank, &seed);
+         if (chunk_p != NULL) my_stats->steals++;
       }
-      if (block_count == blocks){
-        global = 1;
+      if (chunk_p != NULL) {
+         block_p = chunk_p->block_p;
+         Execute_tasks(block_p->tasks + chunk_p->start, chunk_p->count,
+               my_stats);
+         if (__atomic_sub_fetch(&block_p->remaining, 1,
+                  __ATOMIC_ACQ_REL) == 0)
+            Enqueue(&empty_queue, &block_p, 1);
+         continue;
       }
-    // }
-    // else{
-      //wake all threads with broadcast
-      // pthread_cond_broadcast(&condition);
-      // print the new list 
-      //print out which thread did what
-    // }
-    // STOP all threads
-    for (thread = 0; thread < thread_count; thread++)
-        pthread_join(thread_handles[thread], NULL);
-    // DESTROY all threads 
-    free(thread_handles);
-
-   return 0;
-} /* Main */
 
+      n = Dequeue(&full_queue, my_blocks, BATCH);
+      if (n == 0) break;
+      if (n < 0) continue;  /* Woken to steal */
+      for (b = 0; b < n; b++) {
+         block_p = my_blocks[b];
+         block_p->remaining = (block_p->count + CHUNK - 1)/CHUNK;
+         for (c = 0; c < block_p->remaining; c++) {
+            block_p->chunks[c].block_p = block_p;
+            block_p->chunks[c].start = c*CHUNK;
+            block_p->chunks[c].count = (c*CHUNK + CHUNK <= block_p->count) ?
+               CHUNK : block_p->count - c*CHUNK;
+         }
+         /* Push in reverse, so the owner starts at the front */
+         for (c = block_p->remaining - 1; c >= 0; c--)
+            Push_bottom(my_deque, &block_p->chunks[c]);
+      }
+      if (chunks_per_block > 1 || n > 1)
+         Wake_consumers(&full_queue);
+   }
+}  /* Work_stealing */
 
 /*-----------------------------------------------------------------*/
-void ExecuteTasks(struct task* list) {
-   for (int i = 0; i < list.size(); i ++){
-      if ((list + i) -> operation == "i"){
-        Insert((list + i) -> number);
+/* Function:    Execute_tasks
+ * Purpose:     Carry out count tasks.  A run of up to LOCK_RUN
+ *              consecutive tasks that need the same kind of lock is
+ *              carried out with one acquisition of the lock.
+ */
+void Execute_tasks(struct task tasks[], int count,
+      struct stats_s* my_stats) {
+   int t = 0, end, read;
+
+   while (t < count) {
+      read = (tasks[t].operation == 'm');
+      end = t + LOCK_RUN;
+      if (end > count) end = count;
+      if (read)
+         pthread_rwlock_rdlock(&rwlock);
+      else
+         pthread_rwlock_wrlock(&rwlock);
+      for ( ; t < end && (tasks[t].operation == 'm') == read; t++) {
+         switch (tasks[t].operation) {
+            case 'm':
+               my_stats->count[MEMBER_OP]++;
+               my_stats->success[MEMBER_OP] += Member(tasks[t].number);
+               break;
+            case 'i':
+               my_stats->count[INSERT_OP]++;
+               my_stats->success[INSERT_OP] += Insert(tasks[t].number);
+               break;
+            default: /* 'd' */
+               my_stats->count[DELETE_OP]++;
+               my_stats->success[DELETE_OP] += Delete(tasks[t].number);
+         }
       }
-      else if ((list + i) -> operation == "d"){
-        Delete((list + i) -> number);
+      pthread_rwlock_unlock(&rwlock);
+   }
+}  /* Execute_tasks */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Queue_init
+ * Purpose:     Initialize an empty queue
+ */
+void Queue_init(struct queue_s* q_p) {
+   q_p->front = q_p->count = q_p->done = 0;
+   q_p->consumers_waiting = q_p->producers_waiting = 0;
+   q_p->wakeups = 0;
+   pthread_mutex_init(&q_p->mutex, NULL);
+   pthread_cond_init(&q_p->not_empty, NULL);
+   pthread_cond_init(&q_p->not_full, NULL);
+}  /* Queue_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Enqueue
+ * Purpose:     Add n blocks to the rear of the queue, waiting for
+ *              space if the queue is full
+ */
+void Enqueue(struct queue_s* q_p, struct block_s* blocks[], int n) {
+   int i = 0;
+
+   pthread_mutex_lock(&q_p->mutex);
+   while (i < n) {
+      while (q_p->count == QUEUE_SIZE) {
+         q_p->producers_waiting++;
+         pthread_cond_wait(&q_p->not_full, &q_p->mutex);
+         q_p->producers_waiting--;
       }
-      else if ((list + i) -> operation == "m"){
-        Member((list + i) -> number);
+      for ( ; i < n && q_p->count < QUEUE_SIZE; i++) {
+         q_p->blocks[(q_p->front + q_p->count) % QUEUE_SIZE] = blocks[i];
+         q_p->count++;
       }
-      else{
-        printf("This is an invalid operation.\n");
+      if (q_p->consumers_waiting > 0) {
+         if (i > 1)
+            pthread_cond_broadcast(&q_p->not_empty);
+         else
+            pthread_cond_signal(&q_p->not_empty);
       }
    }
-}  /* ExecuteTasks */
+   pthread_mutex_unlock(&q_p->mutex);
+}  /* Enqueue */
 
+/*-----------------------------------------------------------------*/
+/* Function:    Dequeue
+ * Purpose:     Remove up to max blocks from the front of the queue,
+ *              waiting if the queue is empty and not done
+ * Return val:  The number of blocks removed.  0 means the queue is
+ *              empty and done, and -1 means the thread was woken by
+ *              Wake_consumers without getting any blocks.
+ */
+int Dequeue(struct queue_s* q_p, struct block_s* blocks[], int max) {
+   int n = 0;
+   int wakeups;
+
+   pthread_mutex_lock(&q_p->mutex);
+   wakeups = q_p->wakeups;
+   while (q_p->count == 0 && !q_p->done && q_p->wakeups == wakeups) {
+      q_p->consumers_waiting++;
+      pthread_cond_wait(&q_p->not_empty, &q_p->mutex);
+      q_p->consumers_waiting--;
+   }
+   /* Leave some blocks for the other threads when there are few */
+   if (max > 1 && q_p->count < max*thread_count)
+      max = (q_p->count + thread_count - 1)/thread_count;
+   for ( ; n < max && q_p->count > 0; n++) {
+      blocks[n] = q_p->blocks[q_p->front];
+      q_p->front = (q_p->front + 1) % QUEUE_SIZE;
+      q_p->count--;
+   }
+   if (n > 0 && q_p->producers_waiting > 0)
+      pthread_cond_signal(&q_p->not_full);
+   if (n == 0 && !q_p->done) n = -1;
+   pthread_mutex_unlock(&q_p->mutex);
+
+   return n;
+}  /* Dequeue */
 
 /*-----------------------------------------------------------------*/
-void* Spawn_Threads(void* rank)
-{
-    long my_rank = (long) rank; // kludge for deriving thread #'s
-    
-// ********************* THREADS BARRIER *******************
-    
-    pthread_mutex_lock(&mutex);
-    counter++;
-    
-    printf("Hello from thread %ld of %d. Counter == %d. \n", my_rank, thread_count, counter);
-
-    if(counter == thread_count)
-    {
-        printf("All threads synced. Thread %ld setting counter. \n", my_rank);
-        counter = 0;
-        pthread_cond_broadcast(&cond_var);
-    }
-    else
-    {
-        printf("Thread %ld now waiting in barrier. \n", my_rank);
-        while (pthread_cond_wait(&cond_var, &mutex) != 0);
-    }
-    
-    pthread_mutex_unlock(&mutex);
-// ********************* THREADS BARRIER *******************
-
-    return NULL;
-} /* Spawn_Threads */
+/* Function:    Finish
+ * Purpose:     Record that no more blocks will be added to the queue,
+ *              and wake all the threads that are waiting for blocks
+ */
+void Finish(struct queue_s* q_p) {
+   pthread_mutex_lock(&q_p->mutex);
+   q_p->done = 1;
+   pthread_cond_broadcast(&q_p->not_empty);
+   pthread_mutex_unlock(&q_p->mutex);
+}  /* Finish */
 
+/*-----------------------------------------------------------------*/
+/* Function:    Wake_consumers
+ * Purpose:     Wake the threads that are waiting for blocks, so that
+ *              they can look for work somewhere else
+ */
+void Wake_consumers(struct queue_s* q_p) {
+   pthread_mutex_lock(&q_p->mutex);
+   if (q_p->consumers_waiting > 0) {
+      q_p->wakeups++;
+      pthread_cond_broadcast(&q_p->not_empty);
+   }
+   pthread_mutex_unlock(&q_p->mutex);
+}  /* Wake_consumers */
 
 /*-----------------------------------------------------------------*/
-void Usage(char* prog_name) {
-   fprintf(stderr, "Usage: %s <thread_count>\n", prog_name);
-   exit(0);
-}  /* Usage */
+void Queue_destroy(struct queue_s* q_p) {
+   pthread_mutex_destroy(&q_p->mutex);
+   pthread_cond_destroy(&q_p->not_empty);
+   pthread_cond_destroy(&q_p->not_full);
+}  /* Queue_destroy */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Deque_init
+ * Purpose:     Initialize an empty deque that can hold size chunks
+ * Note:        size must be a power of 2
+ */
+void Deque_init(struct deque_s* d_p, long size) {
+   d_p->top = d_p->bottom = 0;
+   d_p->buffer = malloc(size*sizeof(struct chunk_s*));
+   d_p->mask = size - 1;
+}  /* Deque_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Push_bottom
+ * Purpose:     Add a chunk at the bottom of the deque
+ * Note:        Only called by the owner, and only when there's room
+ */
+void Push_bottom(struct deque_s* d_p, struct chunk_s* chunk_p) {
+   long b = __atomic_load_n(&d_p->bottom, __ATOMIC_RELAXED);
+
+   __atomic_store_n(&d_p->buffer[b & d_p->mask], chunk_p, __ATOMIC_RELAXED);
+   __atomic_store_n(&d_p->bottom, b + 1, __ATOMIC_RELEASE);
+}  /* Push_bottom */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Pop_bottom
+ * Purpose:     Remove the chunk at the bottom of the deque
+ * Return val:  The chunk, or NULL if the deque is empty
+ * Note:        Only called by the owner.  If there's one chunk left,
+ *              the owner and a thief race for it with a CAS on top.
+ */
+struct chunk_s* Pop_bottom(struct deque_s* d_p) {
+   long b = __atomic_load_n(&d_p->bottom, __ATOMIC_RELAXED) - 1;
+   long t;
+   struct chunk_s* chunk_p = NULL;
+
+   __atomic_store_n(&d_p->bottom, b, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   t = __atomic_load_n(&d_p->top, __ATOMIC_RELAXED);
+   if (t <= b) {
+      chunk_p = __atomic_load_n(&d_p->buffer[b & d_p->mask],
+            __ATOMIC_RELAXED);
+      if (t == b) {
+         /* Last chunk */
+         if (!__atomic_compare_exchange_n(&d_p->top, &t, t + 1, 0,
+                  __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            chunk_p = NULL;
+         __atomic_store_n(&d_p->bottom, b + 1, __ATOMIC_RELAXED);
+      }
+   } else {
+      /* Empty */
+      __atomic_store_n(&d_p->bottom, b + 1, __ATOMIC_RELAXED);
+   }
+   return chunk_p;
+}  /* Pop_bottom */
+
+/*-----------------------------------------------------------------*/
+/* Function:    Steal_top
+ * Purpose:     Remove the chunk at the top of another thread's deque
+ * Return val:  The chunk, or NULL if the deque is empty or another
+ *              thread got the chunk first
+ */
+struct chunk_s* Steal_top(struct deque_s* d_p) {
+   long t = __atomic_load_n(&d_p->top, __ATOMIC_ACQUIRE);
+   long b;
+   struct chunk_s* chunk_p;
+
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   b = __atomic_load_n(&d_p->bottom, __ATOMIC_ACQUIRE);
+   if (t >= b) return NULL;
+   chunk_p = __atomic_load_n(&d_p->buffer[t & d_p->mask], __ATOMIC_RELAXED);
+   if (!__atomic_compare_exchange_n(&d_p->top, &t, t + 1, 0,
+            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+      return NULL;
+   return chunk_p;
+}  /* Steal_top */
 
+/*-----------------------------------------------------------------*/
+/* Function:    Steal_chunk
+ * Purpose:     Try to steal a chunk from each of the other threads,
+ *              starting with a random one
+ * Return val:  The stolen chunk, or NULL if none was found
+ */
+struct chunk_s* Steal_chunk(long my_rank, unsigned* seed_p) {
+   long start, i, victim;
+   struct chunk_s* chunk_p;
+
+   if (thread_count == 1) return NULL;
+   start = my_rand(seed_p) % thread_count;
+   for (i = 0; i < thread_count; i++) {
+      victim = (start + i) % thread_count;
+      if (victim == my_rank) continue;
+      chunk_p = Steal_top(&deques[victim]);
+      if (chunk_p != NULL) return chunk_p;
+   }
+   return NULL;
+}  /* Steal_chunk */
+
+/*-----------------------------------------------------------------*/
+void Deque_destroy(struct deque_s* d_p) {
+   free(d_p->buffer);
+}  /* Deque_destroy */
 
 /*-----------------------------------------------------------------*/
 /* Insert value in correct numerical location into list */
-void Insert(int value) {
+/* If value is not in list, return 1, else return 0 */
+int Insert(int value) {
    struct list_node_s* curr = head;
    struct list_node_s* pred = NULL;
    struct list_node_s* temp;
-   
-   while (curr != NULL && curr -> data < value) {
+
+   while (curr != NULL && curr->data < value) {
       pred = curr;
-      curr = curr -> next;
+      curr = curr->next;
    }
 
-   if (curr == NULL || curr -> data > value) {
+   if (curr == NULL || curr->data > value) {
       temp = malloc(sizeof(struct list_node_s));
-      temp -> data = value;
-      temp -> next = curr;
+      temp->data = value;
+      temp->next = curr;
       if (pred == NULL)
          head = temp;
       else
-         pred -> next = temp;
+         pred->next = temp;
+      return 1;
    } else { /* value in list */
-      printf("This value is already in the list.\n");
+      return 0;
    }
 }  /* Insert */
 
-
 /*-----------------------------------------------------------------*/
 /* Deletes value from list */
-void Delete(int value) {
+/* If value is in list, return 1, else return 0 */
+int Delete(int value) {
    struct list_node_s* curr = head;
    struct list_node_s* pred = NULL;
 
-   while (curr != NULL && curr -> data < value) {
+   while (curr != NULL && curr->data < value) {
       pred = curr;
-      curr = curr -> next;
+      curr = curr->next;
    }
-   
-   if (curr != NULL && curr -> data == value) {
-      if (pred == NULL) { /* first element in list */
-         head = curr -> next;
-         free(curr);
-      } else { 
-         pred -> next = curr -> next;
-         free(curr);
-      }
+
+   if (curr != NULL && curr->data == value) {
+      if (pred == NULL) /* first element in list */
+         head = curr->next;
+      else
+         pred->next = curr->next;
+      free(curr);
+      return 1;
    } else { /* Not in list */
-      printf("This value was not in the list.\n");
+      return 0;
    }
 }  /* Delete */
 
-
 /*-----------------------------------------------------------------*/
-/* Finds the value in the list */
-void  Member(int value) {
-   struct list_node_s* temp;
+/* Return 1 if value is in list, 0 otherwise */
+int  Member(int value) {
+   struct list_node_s* temp = head;
 
-   temp = head;
-   while (temp != NULL && temp -> data < value)
-      temp = temp -> next;
+   while (temp != NULL && temp->data < value)
+      temp = temp->next;
 
-   if (temp == NULL || temp -> data > value) {
-      printf("This item is not in the list.\n");
-   } else {
-      printf("This item is in the list.\n");
-   }
+   if (temp == NULL || temp->data > value)
+      return 0;
+   else
+      return 1;
 }  /* Member */
 
-
 /*-----------------------------------------------------------------*/
 void Print(void) {
    struct list_node_s* temp;
@@ -319,18 +846,18 @@ void Print(void) {
    printf("\n");
 }  /* Print */
 
-
 /*-----------------------------------------------------------------*/
-void Get_input(int* inserts_p) {
-
-   printf("How many numbers should we have?\n");
-   scanf("%d", inserts_p);
-}  /* Get_input */
-
-
-
-
-
-
-
-
+/* Doesn't use locks.  Can only be run when no other threads are
+ * accessing the list
+ */
+void Free_list(void) {
+   struct list_node_s* current = head;
+   struct list_node_s* following;
+
+   while (current != NULL) {
+      following = current->next;
+      free(current);
+      current = following;
+   }
+   head = NULL;
+}  /* Free_list */
@@ -0,0 +1,166 @@
+/* File:     workload.c
+ *
+ * Purpose:  Generate the keys used by the list benchmarks.  The keys
+ *           are ints in the range 0, 1, ..., max_key-1, and they can
+ *           come from one of four distributions.
+ *
+ * Workload_init:   choose the distribution.  spec is one of
+ *
+ *                     u           uniform (the default)
+ *                     z[theta]    Zipfian with exponent theta,
+ *                                 0 < theta < 1 (default 0.99)
+ *                     s           sequential:  each thread generates
+ *                                 consecutive keys
+ *                     h[f,p]      hot set:  a fraction p of the keys
+ *                                 come from a "hot" set that's a
+ *                                 fraction f of all the keys (default
+ *                                 f = 0.2, p = 0.8)
+ *
+ *                  e.g., "z0.8" or "h0.01,0.9".  Returns 1 if spec is
+ *                  OK, 0 otherwise.  Call once, before starting the
+ *                  threads.
+ * Workload_start:  called by each thread before it generates keys
+ * Workload_key:    return the next key.  seed_p is the calling
+ *                  thread's seed for my_rand
+ *
+ * Notes:
+ * 1.  With the uniform distribution, Workload_key returns
+ *     my_rand(seed_p) % max_key, so the programs generate exactly the
+ *     same keys they did before the other distributions were added.
+ * 2.  The Zipfian keys use the method of Gray et al., "Quickly
+ *     generating billion-record synthetic databases," SIGMOD 1994.
+ *     Computing the normalizing constant zeta(n, theta) takes time
+ *     proportional to n, so only the first ZETA_TERMS terms of the
+ *     sum are added, and the rest are approximated by an integral.
+ * 3.  The Zipfian and hot set distributions pick a "rank" r, where
+ *     smaller ranks are more popular.  The key is r multiplied by a
+ *     large odd constant, mod max_key, so that the popular keys are
+ *     spread through the list instead of being clustered at the head.
+ * 4.  Sequential keys for thread q start at q*max_key/thread_count.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "my_rand.h"
+#include "workload.h"
+
+#define ZETA_TERMS 10000
+#define SPREAD 2654435761UL
+
+static char   dist = 'u';
+static int    keys = 1;
+static int    threads = 1;
+static double theta, alpha, zeta_n, eta;   /* Zipfian */
+static double hot_frac, hot_prob;          /* Hot set */
+static int    hot_count;
+
+static __thread int my_next = 0;           /* Sequential */
+
+static double Zeta(int n, double theta);
+static int    Spread(long r);
+
+/*-----------------------------------------------------------------*/
+/* Function:   Workload_init
+ * Purpose:    Parse the distribution spec and set up its parameters
+ * In args:    spec, max_key, thread_count
+ * Return val: 1 if spec is OK, 0 otherwise
+ */
+int Workload_init(char* spec, int max_key, int thread_count) {
+   keys = max_key;
+   threads = thread_count;
+   dist = spec[0];
+
+   switch (dist) {
+      case 'u':
+      case 's':
+         return spec[1] == '\0';
+      case 'z':
+         theta = 0.99;
+         if (spec[1] != '\0' && sscanf(spec+1, "%lf", &theta) != 1)
+            return 0;
+         if (theta <= 0.0 || theta >= 1.0) return 0;
+         alpha = 1.0/(1.0 - theta);
+         zeta_n = Zeta(keys, theta);
+         eta = (1.0 - pow(2.0/keys, 1.0 - theta))/
+               (1.0 - Zeta(2, theta)/zeta_n);
+         return 1;
+      case 'h':
+         hot_frac = 0.2;
+         hot_prob = 0.8;
+         if (spec[1] != '\0' &&
+               sscanf(spec+1, "%lf,%lf", &hot_frac, &hot_prob) != 2)
+            return 0;
+         if (hot_frac <= 0.0 || hot_frac > 1.0 ||
+               hot_prob < 0.0 || hot_prob > 1.0) return 0;
+         hot_count = hot_frac*keys;
+         if (hot_count < 1) hot_count = 1;
+         return 1;
+      default:
+         return 0;
+   }
+}  /* Workload_init */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Workload_start
+ * Purpose:    Initialize the calling thread's sequential key
+ * In arg:     rank
+ */
+void Workload_start(long rank) {
+   my_next = ((long long) rank*keys)/threads;
+}  /* Workload_start */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Workload_key
+ * Purpose:    Generate the next key
+ * In/out arg: seed_p
+ * Return val: The key
+ */
+int Workload_key(unsigned* seed_p) {
+   double u, uz;
+   int key;
+
+   switch (dist) {
+      case 'z':
+         u = my_drand(seed_p);
+         uz = u*zeta_n;
+         if (uz < 1.0) return Spread(0);
+         if (uz < 1.0 + pow(0.5, theta)) return Spread(1);
+         return Spread((long) (keys*pow(eta*u - eta + 1.0, alpha)));
+      case 's':
+         key = my_next;
+         my_next = (my_next + 1) % keys;
+         return key;
+      case 'h':
+         if (my_drand(seed_p) < hot_prob)
+            return Spread(my_rand(seed_p) % hot_count);
+         else
+            return my_rand(seed_p) % keys;
+      default:
+         return my_rand(seed_p) % keys;
+   }
+}  /* Workload_key */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Zeta
+ * Purpose:    Approximate zeta(n, theta) = sum_{i=1}^n 1/i^theta
+ */
+static double Zeta(int n, double theta) {
+   double sum = 0.0;
+   int i, m = (n < ZETA_TERMS) ? n : ZETA_TERMS;
+
+   for (i = 1; i <= m; i++)
+      sum += 1.0/pow(i, theta);
+   if (n > m)
+      sum += (pow(n + 0.5, 1.0 - theta) - pow(m + 0.5, 1.0 - theta))/
+             (1.0 - theta);
+   return sum;
+}  /* Zeta */
+
+/*-----------------------------------------------------------------*/
+/* Function:   Spread
+ * Purpose:    Map a rank to a key
+ */
+static int Spread(long r) {
+   if (r >= keys) r = keys - 1;
+   return (r*SPREAD) % keys;
+}  /* Spread */
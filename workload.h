@@ -0,0 +1,12 @@
+/* File:     workload.h
+ * Purpose:  Header file for workload.c, which generates the keys used
+ *           by the list benchmarks from one of several distributions.
+ */
+#ifndef _WORKLOAD_H_
+#define _WORKLOAD_H_
+
+int  Workload_init(char* spec, int max_key, int thread_count);
+void Workload_start(long rank);
+int  Workload_key(unsigned* seed_p);
+
+#endif